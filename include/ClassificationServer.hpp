@@ -0,0 +1,210 @@
+//
+//  ClassificationServer.hpp
+//  Film_type_classifier
+//
+
+#ifndef ClassificationServer_hpp
+#define ClassificationServer_hpp
+
+#include <stdio.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <opencv2/opencv.hpp>
+#include "ShotPipeline.hpp"
+#include "MemoryBudget.hpp"
+
+/**
+ * @struct ServerOptions
+ * @brief Tunables of the ClassificationServer request queue.
+ */
+struct ServerOptions {
+    size_t queue_capacity = 64;                 ///< Max queued image requests; further requests are answered with BUSY
+    size_t max_batch = 16;                      ///< Max image requests a worker takes from the queue at once
+    size_t worker_count = 1;                    ///< Image worker threads (each batch is already processed in parallel)
+    size_t video_queue_capacity = 4;            ///< Max queued VIDEO requests; further requests are answered with BUSY
+    size_t video_worker_count = 1;              ///< Threads classifying VIDEO requests, one video each
+    size_t max_payload_bytes = 64 * 1024 * 1024;///< Max size of a BYTES request payload
+    size_t max_connections = 64;                ///< Max open connections (one thread each); further ones get BUSY and are closed
+};
+
+/**
+ * @class ClassificationServer
+ * @brief Long-running classification service listening on a Unix domain socket.
+ *
+ * Keeps the detector pools and the pipeline warm between requests, so a client
+ * only pays for the classification itself. The protocol is line based; every
+ * request line gets exactly one response line:
+ *
+ * @code
+ *   IMAGE <path>                    classify one image file
+ *   VIDEO <start_ms> <end_ms> <path> classify a video range (end_ms < 0 = until end)
+ *   BYTES <size>                    followed by <size> bytes of an encoded image (JPEG, PNG, ...)
+ *   STATS                           server counters
+ *   SHUTDOWN                        stop the server after answering queued requests
+ *
+ *   OK <type> <confidence> frames=<n> CLOSE_UP=<n> MEDIUM=<n> WIDE=<n> BLACK=<n> CREDITS=<n> UNKNOWN=<n>
+ *   ERROR <message>
+ *   BUSY                            queue is full, retry later (after BYTES on a new connection)
+ * @endcode
+ *
+ * For a video, `<type>` is the dominant shot type and `<confidence>` its share of frames.
+ *
+ * Every connection is served by its own thread. At most `max_connections` are open at once;
+ * a connection beyond that gets a single `BUSY` line and is closed right away.
+ *
+ * Image requests (IMAGE, BYTES) from all connections go to one bounded queue. Workers
+ * take up to `max_batch` of them at a time and classify them in parallel. VIDEO requests
+ * have their own queue and workers, so a long video does not delay image requests: at most
+ * `video_worker_count` videos are classified at once and each of them holds its worker for
+ * the whole requested range. When a queue is full, requests are rejected with BUSY instead
+ * of piling up, which gives clients explicit backpressure. With a MemoryBudget set, a BYTES
+ * payload is reserved in the LOADER_QUEUE share from its announced size before it is read.
+ * If it does not fit next to the payloads already held, the payload is read and discarded
+ * without being stored and the request gets BUSY; the connection stays open. A payload
+ * larger than the whole share (up to `max_payload_bytes`) is accepted only while no other
+ * payload is held. Decoded images are classified early when they reach the FRAME_POOL share,
+ * and the timeline of a VIDEO request is spilled to disk by its STATISTICS share.
+ *
+ * @see ShotPipeline
+ * @see ClassificationClient
+ */
+class ClassificationServer
+{
+    /// Single queued request and the promise its connection waits on.
+    struct Job {
+        std::string command;              ///< IMAGE, VIDEO or BYTES
+        std::string path;                 ///< File path (IMAGE, VIDEO)
+        double start_ms = 0.;             ///< Range start (VIDEO)
+        double end_ms = -1.;              ///< Range end (VIDEO)
+        std::vector<uchar> payload;       ///< Encoded image (BYTES)
+        std::promise<std::string> response; ///< Response line without the newline
+    };
+
+    /// Bounded queue of one kind of requests, guarded by queue_mutex.
+    struct JobQueue {
+        std::deque<std::unique_ptr<Job>> jobs; ///< Pending requests
+        std::condition_variable ready;         ///< Signals workers about new jobs or shutdown
+        size_t capacity = 0;                   ///< Max pending requests
+    };
+
+    /// Client connection served by its own thread.
+    struct Connection {
+        int fd = -1;                      ///< Client socket, closed by the connection thread
+        bool finished = false;            ///< Set when the thread is done and can be joined
+        std::thread thread;               ///< Thread running handleConnection()
+    };
+
+    ShotPipeline& pipeline;               ///< Warm pipeline shared by all workers
+    ServerOptions options;                ///< Queue configuration
+    std::string socket_path;              ///< Path of the listening socket
+    int listen_fd = -1;                   ///< Listening socket descriptor, owned by run() while it runs
+    int wake_pipe[2] = {-1, -1};          ///< Self-pipe waking run() for stop() or SHUTDOWN
+    std::mutex run_mutex;                 ///< Held by run() while it accepts connections
+
+    std::mutex queue_mutex;               ///< Guards both job queues
+    JobQueue image_queue;                 ///< Pending IMAGE and BYTES requests
+    JobQueue video_queue;                 ///< Pending VIDEO requests
+    std::atomic<bool> stopping{false};    ///< Set by stop(), no new requests are accepted
+    std::once_flag stop_once;             ///< Makes stop() safe to call repeatedly
+
+    std::mutex connection_mutex;          ///< Guards connections
+    std::list<Connection> connections;    ///< Open and finished but not yet joined connections
+    std::vector<std::thread> workers;     ///< Worker threads of both queues
+
+    std::atomic<size_t> served_count{0};  ///< Requests answered with OK
+    std::atomic<size_t> rejected_count{0};///< Requests answered with BUSY
+    std::atomic<size_t> failed_count{0};  ///< Requests answered with ERROR
+    MemoryBudget* memory_budget = nullptr;///< Optional budget for queued payloads and decoded frames
+
+    void handleConnection(Connection* connection);
+    void reapConnections();
+    void wakeAcceptLoop();
+    std::string handleRequest(int fd, const std::string& line, std::string& buffer, bool& keepOpen);
+    std::string enqueue(std::unique_ptr<Job> job);
+    void workerLoop(JobQueue& queue, size_t maxBatch);
+    void processJobs(std::vector<std::unique_ptr<Job>>& jobs);
+    void classifyFrames(std::vector<cv::Mat>& frames, std::vector<Job*>& frameJobs);
+
+public:
+    /**
+     * @brief Constructs the server around a warm pipeline.
+     * @param shotPipeline Pipeline used for all requests.
+     * @param serverOptions Queue configuration.
+     */
+    ClassificationServer(ShotPipeline& shotPipeline, const ServerOptions& serverOptions = ServerOptions())
+        : pipeline(shotPipeline), options(serverOptions)
+    {
+        image_queue.capacity = options.queue_capacity;
+        video_queue.capacity = options.video_queue_capacity;
+    }
+
+    /**
+     * @brief Stops the server if it is still running.
+     */
+    ~ClassificationServer();
+
+    /**
+     * @brief Bounds queued payloads, decoded frames and VIDEO timelines by a budget. Call before start().
+     * @param budget Budget to respect (nullptr = only `queue_capacity` limits the queue).
+     */
+    void setMemoryBudget(MemoryBudget* budget) { memory_budget = budget; }
+
+    /**
+     * @brief Binds the socket and starts the worker threads.
+     * @param path Path of the Unix domain socket to create (an existing socket file is replaced).
+     * @throws std::runtime_error if the socket cannot be created or another kind of file exists at `path`.
+     */
+    void start(const std::string& path);
+
+    /**
+     * @brief Accepts connections until stop() is called or a SHUTDOWN request arrives.
+     *
+     * Blocks the calling thread and stops the server before returning. Finished
+     * connection threads are joined whenever a new connection is accepted.
+     */
+    void run();
+
+    /**
+     * @brief Closes the socket, answers queued requests and joins all threads.
+     *
+     * May be called from any thread; a run() in progress is woken and returns.
+     */
+    void stop();
+};
+
+/**
+ * @class ClassificationClient
+ * @brief Minimal client for ClassificationServer, used by the `--client` mode and for local testing.
+ */
+class ClassificationClient
+{
+    int fd = -1;          ///< Connected socket
+    std::string buffer;   ///< Received bytes not yet returned
+
+public:
+    /**
+     * @brief Connects to a running server.
+     * @param path Path of the server's Unix domain socket.
+     * @throws std::runtime_error if the connection fails.
+     */
+    explicit ClassificationClient(const std::string& path);
+    ~ClassificationClient();
+
+    ClassificationClient(const ClassificationClient&) = delete;
+    ClassificationClient& operator=(const ClassificationClient&) = delete;
+
+    /**
+     * @brief Sends one request and waits for its response line.
+     * @param line Request line without the newline (e.g. "IMAGE test/wide/1.jpg").
+     * @param payload Optional raw bytes sent after the line (for BYTES requests).
+     * @return Response line without the newline.
+     */
+    std::string request(const std::string& line, const std::vector<uchar>& payload = {});
+};
+
+#endif /* ClassificationServer_hpp */
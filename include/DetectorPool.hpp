@@ -0,0 +1,178 @@
+//
+//  DetectorPool.hpp
+//  Film_type_classifier
+//
+
+#ifndef DetectorPool_hpp
+#define DetectorPool_hpp
+
+#include <stdio.h>
+#include <memory>
+#include <mutex>
+#include <opencv2/opencv.hpp>
+#include "FeatureDetector.hpp"
+#include "MemoryBudget.hpp"
+
+/**
+ * @class DetectorPool
+ * @brief Shares one Haar cascade model between many per-thread FeatureDetector instances.
+ *
+ * `cv::CascadeClassifier` is not safe to use from several threads at once, so every
+ * worker needs its own FeatureDetector. Constructing each of them from the model path
+ * reads and parses the XML file again. The pool parses the model once into a shared
+ * CascadeModel and builds detectors from the parsed tree on demand; released detectors
+ * are kept idle and handed out again on the next checkout.
+ *
+ * Detectors are created lazily when checked out, so a single-frame run builds one detector
+ * per pool. `warmUp()` can be used to build a number of detectors ahead of time, e.g. for
+ * a long-running server. Detectors are built concurrently from the shared tree, so the first
+ * batch on N threads starts about as fast as a single-threaded run (at most twice the time,
+ * checked by PipelineReplay::checkStartup()).
+ *
+ * There is no warm start from a serialized model cache: `cv::CascadeClassifier` can only be
+ * loaded through `cv::FileStorage` (XML, YAML or JSON text), so any cache file would go
+ * through the same parser. Parsing happens once per pool at startup instead.
+ *
+ * A single large still can be split into overlapping tiles detected in parallel (see
+ * detectTiled()). Every tile task checks out its own detector, so tiles share the pool's
+ * detectors with the frame-parallel workers instead of each detector holding extra cascades.
+ *
+ * With a MemoryBudget set, every detector is accounted to DETECTION_CACHE (estimated by the
+ * size of the model file). When a detector is returned while the cache is over its limit,
+ * it is destroyed instead of kept idle, unless it is the last one of the pool. warmUp()
+ * stops at the limit.
+ *
+ * Example usage:
+ * @code
+ *   DetectorPool frontal_pool("haarcascade_frontalface_default.xml");
+ *   frontal_pool.warmUp(cv::getNumThreads());
+ *   // inside a worker thread
+ *   DetectorPool::Lease detector = frontal_pool.checkout();
+ *   std::vector<DetectedFeature> faces = detector->detect(frame);
+ * @endcode
+ *
+ * @see FeatureDetector
+ */
+class DetectorPool
+{
+    std::shared_ptr<CascadeModel> model;                  ///< Cascade XML file, read and parsed once
+    std::mutex pool_mutex;                                ///< Guards idle_detectors and created_count
+    std::vector<std::unique_ptr<FeatureDetector>> idle_detectors; ///< Detectors not checked out at the moment
+    size_t created_count = 0;                             ///< Number of detectors built by this pool
+    MemoryBudget* memory_budget = nullptr;                ///< Optional budget for the parsed cascades
+
+    std::unique_ptr<FeatureDetector> createDetector() const;
+    void release(std::unique_ptr<FeatureDetector> detector);
+    long long detectorBytes() const;
+    void reset();
+
+public:
+    /**
+     * @class Lease
+     * @brief Exclusive handle to a pooled FeatureDetector, returned to the pool on destruction.
+     */
+    class Lease
+    {
+        DetectorPool* pool = nullptr;               ///< Owning pool
+        std::unique_ptr<FeatureDetector> detector;  ///< Checked out detector
+
+    public:
+        Lease(DetectorPool* owner, std::unique_ptr<FeatureDetector> checkedOut)
+            : pool(owner), detector(std::move(checkedOut)) {}
+        Lease(Lease&& other) = default;
+        Lease& operator=(Lease&& other);
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        ~Lease();
+
+        FeatureDetector& operator*() const { return *detector; }
+        FeatureDetector* operator->() const { return detector.get(); }
+    };
+
+    /**
+     * @brief Constructs the pool and immediately loads the model.
+     * @param modelPath Path to the Haar cascade XML model file.
+     */
+    explicit DetectorPool(const std::string& modelPath) { loadModel(modelPath); }
+
+    /**
+     * @brief Constructs the pool without loading a model initially.
+     */
+    DetectorPool() {}
+
+    DetectorPool(const DetectorPool&) = delete;
+    DetectorPool& operator=(const DetectorPool&) = delete;
+    ~DetectorPool();
+
+    /**
+     * @brief Reads and parses the cascade model file and builds the first detector.
+     * @param modelPath Path to the Haar cascade XML model file.
+     * @throws std::runtime_error if the file cannot be read or is not a valid cascade.
+     */
+    void loadModel(const std::string& modelPath);
+
+    /**
+     * @brief Parses a model already held in memory and builds the first detector.
+     * @param modelBuffer Full content of a Haar cascade XML model file.
+     * @throws std::runtime_error if the buffer is not a valid cascade.
+     */
+    void loadModelFromMemory(const std::string& modelBuffer);
+
+    /**
+     * @brief Hands out a detector for exclusive use by the calling thread.
+     *
+     * Reuses an idle detector when one is available, otherwise builds a new one
+     * from the parsed model.
+     *
+     * @return Lease that gives the detector back to the pool when destroyed.
+     */
+    Lease checkout();
+
+    /**
+     * @brief Detects faces on one large frame split into tiles processed in parallel.
+     *
+     * The frame is cut into up to `cv::getNumThreads()` tiles, none narrower or lower than
+     * `maxFaceSize`. Tiles overlap by the maximum face size, so every face up to that size
+     * lies completely inside at least one tile. Faces larger than that are found by a
+     * parallel full-frame pass restricted to the coarse scales at or above the maximum face
+     * size. Duplicates at tile seams and between the passes are merged with non-maximum
+     * suppression. Every task checks out its own detector from this pool, so the number of
+     * tiles is bounded only by the thread count and the frame size.
+     *
+     * Frames smaller than two tiles, or a single-threaded run, are detected on the full frame.
+     *
+     * Tolerance compared to full-frame detection: the largest face of a frame is found with
+     * IoU >= 0.5, and at least 90 % of all full-frame faces are found with IoU >= 0.5. Faces
+     * that are borderline for the cascade's neighbour grouping may appear or disappear when
+     * they sit on a tile border. PipelineReplay::checkTiling() verifies this on the test images.
+     *
+     * @param gray Grayscale frame.
+     * @param maxFaceSize Largest face (in pixels) that has to be found inside a tile.
+     * @param nmsThreshold Overlap (IoU or containment) above which detections are merged.
+     * @return Detections sorted from the biggest bounding box.
+     */
+    std::vector<DetectedFeature> detectTiled(const cv::Mat& gray, int maxFaceSize, double nmsThreshold = 0.4);
+
+    /**
+     * @brief Builds detectors until at least `count` exist.
+     * @param count Number of detectors the pool should hold (e.g. worker thread count).
+     */
+    void warmUp(size_t count);
+
+    /**
+     * @brief Accounts the detectors to the DETECTION_CACHE share of a budget.
+     *
+     * Idle detectors are moved from the previous budget, so call it while no detector
+     * is checked out.
+     *
+     * @param budget Budget to respect (nullptr = unbounded).
+     */
+    void setMemoryBudget(MemoryBudget* budget);
+
+    /**
+     * @brief Returns the number of detectors built so far.
+     */
+    size_t size();
+};
+
+#endif /* DetectorPool_hpp */
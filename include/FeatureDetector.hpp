@@ -9,9 +9,42 @@
 #define FeatureDetector_hpp
 
 #include <stdio.h>
+#include <memory>
 #include <opencv2/opencv.hpp>
 #include "UserStructs.hpp"
 
+/**
+ * @struct CascadeModel
+ * @brief Haar cascade XML parsed once into a `cv::FileStorage` tree, shared by many detectors.
+ *
+ * Parsing the XML text is the expensive part of loading a cascade. Building a
+ * `cv::CascadeClassifier` from the already parsed tree only converts its nodes.
+ * The tree is never modified after parsing and reading FileNodes only walks it, so
+ * several detectors are built from one model concurrently without locking.
+ */
+struct CascadeModel {
+    cv::FileStorage storage;  ///< Parsed XML tree of the model
+    size_t source_bytes = 0;  ///< Size of the XML text, used to estimate the size of a built cascade
+};
+
+/**
+ * @brief Parses the content of a Haar cascade XML file.
+ * @param modelBuffer Full content of a Haar cascade XML model file.
+ * @return Parsed model, ready to be shared between detectors.
+ * @throws std::runtime_error if the buffer cannot be parsed.
+ */
+std::shared_ptr<CascadeModel> parseCascadeModel(const std::string& modelBuffer);
+
+/**
+ * @brief Orders face bounding boxes from the biggest one.
+ *
+ * Boxes of equal area are ordered by their top edge, then left edge, then width, so
+ * every set of detections has exactly one sorted order regardless of how it was found.
+ *
+ * @return True if `a` comes before `b`.
+ */
+bool isBiggerFace(const cv::Rect& a, const cv::Rect& b);
+
 /**
  * @class FeatureDetector
  * @brief Detects visual features (e.g., faces) in an image using Haar cascade models.
@@ -23,18 +56,24 @@
  * It may be beneficial to sort the output vector by bounding box size (e.g., largest first),
  * to simplify downstream feature selection or analysis.
  *
+ * `cv::CascadeClassifier` is not thread-safe, so one instance must not be used from several
+ * threads at once. Tiled detection of a large frame therefore uses several detectors of a
+ * DetectorPool (see DetectorPool::detectTiled()).
+ *
  * @see DetectedFeature
+ * @see DetectorPool
  */
 class FeatureDetector
 {
     cv::CascadeClassifier cascade; ///< The loaded Haar cascade classifier used for detection.
+    std::string label = "face";    ///< Label assigned to every detection of this model.
 
 public:
     /**
      * @brief Constructs the detector and immediately loads the model.
      * @param modelPath Path to the Haar cascade XML model file.
      */
-    FeatureDetector(std::string& modelPath) { loadModel(modelPath); }
+    FeatureDetector(const std::string& modelPath) { loadModel(modelPath); }
 
     /**
      * @brief Constructs the detector without loading a model initially.
@@ -52,6 +91,34 @@ public:
      */
     void loadModel(const std::string& modelPath);
 
+    /**
+     * @brief Loads a Haar cascade model from an in-memory copy of its XML file.
+     *
+     * @param modelBuffer Full content of a Haar cascade XML model file.
+     */
+    void loadModelFromMemory(const std::string& modelBuffer);
+
+    /**
+     * @brief Builds the cascade from an already parsed model without parsing the XML again.
+     *
+     * Used by DetectorPool, which parses the model once and shares it with all its detectors.
+     *
+     * @param parsedModel Model returned by parseCascadeModel().
+     * @throws std::runtime_error if the model does not describe a valid cascade.
+     */
+    void loadModel(const std::shared_ptr<CascadeModel>& parsedModel);
+
+    /**
+     * @brief Checks whether a model has been loaded.
+     * @return True if the detector is ready to use.
+     */
+    bool isLoaded() const { return !cascade.empty(); }
+
+    /**
+     * @brief Returns the label assigned to every detection of this model.
+     */
+    const std::string& getLabel() const { return label; }
+
     /**
      * @brief Detects features in the given image.
      *
@@ -62,6 +129,22 @@ public:
      * @return A vector of `DetectedFeature` representing all detected objects.
      */
     std::vector<DetectedFeature> detect(const cv::Mat& image); // maybe it will be fine to sort the vector from biggest BB, so we gonna have easier job afterwards
+
+    /**
+     * @brief Runs the cascade on a grayscale image (or a region of one) within a size range.
+     *
+     * @param gray Grayscale image; for a region, the returned boxes are relative to it.
+     * @param minSize Smallest face searched for.
+     * @param maxSize Largest face searched for (empty = no limit).
+     * @return Unsorted bounding boxes.
+     */
+    std::vector<cv::Rect> detectFaces(const cv::Mat& gray, const cv::Size& minSize,
+                                      const cv::Size& maxSize = cv::Size());
+
+    /**
+     * @brief Returns the smallest face size detect() searches for.
+     */
+    static cv::Size getMinFaceSize() { return cv::Size(30, 30); }
 };
 
 #endif /* FeatureDetector_hpp */
@@ -48,6 +48,20 @@ public:
      * @return A populated ShotFeatures structure.
      */
     ShotFeatures extract(const cv::Mat& frame, const std::vector<DetectedFeature>& features);
+
+    /**
+     * @brief Decides from global frame statistics whether face detection is worth running.
+     *
+     * Recognizes black frames and credits (bright text in narrow strokes and separate lines
+     * on a dark background without any skin-toned pixel), and rejects frames that cannot
+     * hold a face of the minimal detector size: flat frames without edges and colour frames
+     * without enough skin-toned pixels for such a face. The test is
+     * conservative, a frame is rejected only when a detection would almost surely be empty.
+     *
+     * @param global Statistics computed by Preprocessing::ComputeGlobalFeatures().
+     * @return FrameContent::REGULAR if the detectors should run.
+     */
+    FrameContent prefilter(const GlobalFrameFeatures& global) const;
 };
 
 
@@ -59,7 +73,8 @@ public:
  * Typically used after feature extraction from a single video frame.
  *
  * The classification logic is based on heuristics, such as the relative size of
- * detected objects compared to the frame.
+ * detected objects compared to the frame. Frames the pre-classification marked as
+ * black or credits are classified as ShotType::BLACK / ShotType::CREDITS directly.
  *
  * @see ShotFeatures
  * @see ClassificationResult
@@ -10,6 +10,7 @@
 
 #include <stdio.h>
 #include <opencv2/opencv.hpp>
+#include "UserStructs.hpp"
 
 /**
  * @class InputSource
@@ -67,8 +68,23 @@ public:
  */
 class ImageLoader : public InputSource
 {
+    cv::Mat image;               ///< Loaded image, shared (not copied) with callers of nextFrame()
+    bool frame_returned = false; ///< True once the image has been handed out
+
 public:
-    using InputSource::InputSource;
+    /**
+     * @brief Loads the image from disk.
+     * @param path Path to the image file.
+     * @throws std::runtime_error if the image cannot be read.
+     */
+    explicit ImageLoader(const std::string& path);
+
+    /**
+     * @brief Wraps an already decoded image (e.g. received over a socket).
+     * @param name Name used as source path in messages.
+     * @param frame Decoded image; only the header is copied.
+     */
+    ImageLoader(const std::string& name, const cv::Mat& frame);
 
     /**
      * @brief Checks if the image is still available to be returned.
@@ -91,16 +107,52 @@ public:
 
 /**
  * @class VideoLoader
- * @brief Placeholder for a video-based implementation of InputSource.
+ * @brief InputSource iterating over the frames of a video file.
  *
- * This class will provide functionality to iterate over frames from a video file.
- * Not implemented yet.
+ * Optionally restricted to a time range. The loader reads one frame ahead so that
+ * hasNextFrame() can answer without touching the file. Every frame is decoded into
+ * its own buffer, so a frame returned by nextFrame() stays valid after later calls
+ * and can be kept for batched processing without a deep copy.
  */
 class VideoLoader : public InputSource
 {
+    cv::VideoCapture capture;     ///< Opened video file
+    cv::Mat current_frame;        ///< Frame returned by the last nextFrame() call
+    cv::Mat pending_frame;        ///< Frame read ahead of time
+    double current_timestamp = 0.;///< Timestamp of current_frame in ms
+    double pending_timestamp = 0.;///< Timestamp of pending_frame in ms
+    double end_ms = -1.;          ///< End of the requested range in ms (negative = until end of file)
+    bool has_pending = false;     ///< True if pending_frame holds a frame within the range
+
+    void readAhead();
+
 public:
-    using InputSource::InputSource;
-    // Implementation will follow similar to ImageLoader
+    /**
+     * @brief Opens the video and positions it at the start of the range.
+     * @param path Path to the video file.
+     * @param startMs Start of the range in milliseconds.
+     * @param endMs End of the range in milliseconds (negative = until end of file).
+     * @throws std::runtime_error if the video cannot be opened.
+     */
+    explicit VideoLoader(const std::string& path, double startMs = 0., double endMs = -1.);
+
+    /**
+     * @brief Checks if another frame within the range is available.
+     * @return True if nextFrame() will return a frame.
+     */
+    bool hasNextFrame() const override;
+
+    /**
+     * @brief Returns the next frame and reads the following one ahead.
+     * @return Reference to the frame (`cv::Mat`); a copied header keeps the pixels after later calls.
+     */
+    cv::Mat& nextFrame() override;
+
+    /**
+     * @brief Returns the timestamp of the frame returned by the last nextFrame() call.
+     * @return Timestamp in milliseconds.
+     */
+    double getCurrentTimestamp() const override;
 };
 
 /**
@@ -131,7 +183,7 @@ public:
     /**
      * @brief Destructor.
      */
-    ~Preprocessing();
+    ~Preprocessing() = default;
 
     /**
      * @brief Loads a new frame into the processor.
@@ -145,6 +197,20 @@ public:
      */
     cv::Mat& GetProcessedImage();
 
+    /**
+     * @brief Computes whole-frame statistics used to skip face detection.
+     *
+     * The frame is downscaled so that its width is at most `maxWidth` and converted to YCrCb.
+     * Luminance statistics, edge density (luminance steps to the left and upper neighbour),
+     * skin-tone and colour coverage are counted with whole-image OpenCV operations
+     * (`meanStdDev`, `compare`, `inRange`, `absdiff`, `countNonZero`), which are vectorized.
+     * Only the horizontal runs of bright pixels (letter strokes) are a scalar scan per row.
+     *
+     * @param maxWidth Width the frame is downscaled to before the pass.
+     * @return Global features of the loaded frame.
+     */
+    GlobalFrameFeatures ComputeGlobalFeatures(int maxWidth = 160) const;
+
     // Future: add methods for specific preprocessing steps (blur, resize, etc.)
 };
 
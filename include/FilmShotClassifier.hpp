@@ -10,10 +10,16 @@
 #define FilmShotClassifier_hpp
 
 #include "FeatureDetector.hpp"
+#include "DetectorPool.hpp"
 #include "FeatureProccesorAndClassifier.hpp"
 #include "FileLoader.hpp"
 #include "FilmStatisticEval.hpp"
 #include "ResultDisplayer.hpp"
+#include "TestDatasetEval.hpp"
+#include "ShotPipeline.hpp"
+#include "ShotColumnStore.hpp"
+#include "ClassificationServer.hpp"
+#include "MemoryBudget.hpp"
 #include "UserStructs.hpp"
 
 #endif //FilmShotClassifier_hpp
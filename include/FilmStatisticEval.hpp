@@ -9,8 +9,13 @@
 #define FilmStatisticEval_hpp
 
 #include <stdio.h>
+#include <functional>
+#include <memory>
 #include <opencv2/opencv.hpp>
 #include "UserStructs.hpp"
+#include "MemoryBudget.hpp"
+
+struct TimelineSpill;
 
 /**
  * @class FilmStatistics
@@ -27,6 +32,12 @@
  * The analysis can be configured to skip frames using a configurable `step`,
  * which allows subsampling of the video.
  *
+ * With a MemoryBudget set, the timeline is written to a temporary file whenever its
+ * in-memory part exceeds the STATISTICS share of the budget, so memory stays flat for
+ * inputs of any length. The in-memory part stays accounted until the object is destroyed.
+ * Copies share the spilled part until one of them spills again, which then continues in
+ * its own copy of the file (copy-on-write).
+ *
  * Example usage:
  * @code
  *   FilmStatistics stats(5); // analyze every 5th frame
@@ -47,6 +58,13 @@ class FilmStatistics
     std::vector<std::pair<double, ShotType>> timeline; ///< Timeline of shot types (timestamp → type)
     int totalFrames = 0; ///< Total number of frames processed
 
+    MemoryBudget* memory_budget = nullptr; ///< Optional budget limiting the in-memory timeline
+    std::string spill_directory;           ///< Directory of the spill file
+    std::shared_ptr<TimelineSpill> spill;  ///< Timeline entries already written to disk
+
+    void spillTimeline();
+    void visitTimeline(const std::function<void(double, ShotType)>& visitor) const;
+
 public:
     /**
      * @brief Default constructor (analyzes every frame).
@@ -55,9 +73,27 @@ public:
 
     /**
      * @brief Constructor with custom frame stride.
-     * @param stride Number of frames to skip between evaluations (e.g. 1 = every frame, 5 = every 5th).
+     * @param stride Number of frames to skip between evaluations (e.g. 1 = every frame, 5 = every 5th; 0 is treated as 1).
+     */
+    FilmStatistics(size_t stride) : step(stride > 0 ? stride : 1) {};
+
+    /**
+     * @brief Copies the statistics; the copy's in-memory timeline is accounted to the same budget.
+     */
+    FilmStatistics(const FilmStatistics& other);
+
+    /**
+     * @brief Takes over the statistics together with their budget accounting.
+     */
+    FilmStatistics(FilmStatistics&& other) noexcept;
+
+    FilmStatistics& operator=(const FilmStatistics& other);
+    FilmStatistics& operator=(FilmStatistics&& other) noexcept;
+
+    /**
+     * @brief Releases the STATISTICS accounting of the in-memory timeline.
      */
-    FilmStatistics(size_t stride) : step(stride) {};
+    ~FilmStatistics();
 
     /**
      * @brief Adds the classification result for a single frame.
@@ -87,6 +123,44 @@ public:
      * @brief Prints a textual summary of the shot distribution to the console.
      */
     void printSummary() const;
+
+    /**
+     * @brief Returns the number of analyzed frames per shot type.
+     */
+    const std::map<ShotType, int>& getShotCounts() const { return shot_counts; }
+
+    /**
+     * @brief Returns the in-memory (not yet spilled) part of the timeline (timestamp → type).
+     */
+    const std::vector<std::pair<double, ShotType>>& getTimeline() const { return timeline; }
+
+    /**
+     * @brief Returns the whole timeline, reading back entries spilled to disk.
+     */
+    std::vector<std::pair<double, ShotType>> loadTimeline() const;
+
+    /**
+     * @brief Limits the in-memory timeline to the STATISTICS share of a budget.
+     *
+     * @param budget Budget to respect (nullptr keeps the whole timeline in memory).
+     * @param spillDirectory Directory for the spill file (empty = system temporary directory).
+     */
+    void setMemoryBudget(MemoryBudget* budget, const std::string& spillDirectory = "");
+
+    /**
+     * @brief Returns the number of frames passed to addFrameResult(), including skipped ones.
+     */
+    int getTotalFrames() const { return totalFrames; }
+
+    /**
+     * @brief Returns the number of frames actually analyzed (after applying the step).
+     */
+    int getAnalyzedFrames() const;
+
+    /**
+     * @brief Returns the most frequent shot type, or UNKNOWN if nothing was analyzed.
+     */
+    ShotType getDominantShotType() const;
 };
 
 #endif /* FilmStatisticEval_hpp */
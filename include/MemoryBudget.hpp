@@ -0,0 +1,128 @@
+//
+//  MemoryBudget.hpp
+//  Film_type_classifier
+//
+
+#ifndef MemoryBudget_hpp
+#define MemoryBudget_hpp
+
+#include <stdio.h>
+#include <array>
+#include <atomic>
+#include <opencv2/opencv.hpp>
+
+/**
+ * @enum MemoryComponent
+ * @brief Parts of the application whose memory use is bounded by a MemoryBudget.
+ */
+enum class MemoryComponent {
+    LOADER_QUEUE,    ///< Requests / encoded inputs waiting to be processed
+    FRAME_POOL,      ///< Decoded frames held for batched classification
+    DETECTION_CACHE, ///< Parsed cascade instances kept by DetectorPools
+    STATISTICS,      ///< In-memory part of FilmStatistics timelines
+    COUNT            ///< Number of components (not a component)
+};
+
+constexpr size_t kMemoryComponentCount = (size_t)MemoryComponent::COUNT;
+
+/**
+ * @brief Returns a printable name of the component (e.g. "FRAME_POOL").
+ */
+std::string memoryComponentToString(MemoryComponent component);
+
+/**
+ * @class MemoryBudget
+ * @brief Global RAM budget split between components, with current and peak usage per component.
+ *
+ * Every component gets a share of the total budget. Components report their usage with
+ * add()/setUsage() and query getLimit() to decide how much to hold: the frame pool shrinks
+ * batches, detector pools drop idle detectors, the server rejects requests with BUSY and
+ * FilmStatistics spills its timeline to disk. Usage is an estimate of the data each
+ * component owns; the process resident set size is reported next to it for comparison.
+ *
+ * All methods are thread-safe.
+ *
+ * Example usage:
+ * @code
+ *   MemoryBudget budget(512 * 1024 * 1024);
+ *   frontal_pool.setMemoryBudget(&budget);
+ *   pipeline.setMemoryBudget(&budget);
+ *   film_stats.setMemoryBudget(&budget);
+ *   ...
+ *   budget.printReport();
+ * @endcode
+ */
+class MemoryBudget
+{
+    size_t total_bytes;                                     ///< Total budget
+    std::array<double, kMemoryComponentCount> shares;             ///< Fraction of the budget per component
+    std::array<std::atomic<size_t>, kMemoryComponentCount> current{}; ///< Current usage per component
+    std::array<std::atomic<size_t>, kMemoryComponentCount> peak{};    ///< Peak usage per component
+
+    void updatePeak(size_t index, size_t value);
+
+public:
+    /**
+     * @brief Creates a budget with the default split
+     *        (loader queue 15 %, frame pool 40 %, detection cache 35 %, statistics 10 %).
+     * @param totalBytes Total budget in bytes.
+     */
+    explicit MemoryBudget(size_t totalBytes);
+
+    MemoryBudget(const MemoryBudget&) = delete;
+    MemoryBudget& operator=(const MemoryBudget&) = delete;
+
+    /**
+     * @brief Changes the fraction of the budget given to a component.
+     * @param component Component to change.
+     * @param share Fraction of the total budget (0-1).
+     */
+    void setShare(MemoryComponent component, double share);
+
+    /**
+     * @brief Returns the number of bytes the component may hold.
+     */
+    size_t getLimit(MemoryComponent component) const;
+
+    /**
+     * @brief Returns the total budget in bytes.
+     */
+    size_t getTotal() const { return total_bytes; }
+
+    /**
+     * @brief Adds to (positive) or removes from (negative) the usage of a component.
+     */
+    void add(MemoryComponent component, long long bytes);
+
+    /**
+     * @brief Returns the current usage of a component in bytes.
+     */
+    size_t getCurrent(MemoryComponent component) const;
+
+    /**
+     * @brief Returns the highest usage of a component seen so far in bytes.
+     */
+    size_t getPeak(MemoryComponent component) const;
+
+    /**
+     * @brief Checks whether adding `bytes` keeps the component within its limit.
+     */
+    bool fits(MemoryComponent component, size_t bytes) const;
+
+    /**
+     * @brief Prints current and peak usage per component and the process RSS.
+     */
+    void printReport() const;
+};
+
+/**
+ * @brief Returns the current resident set size of the process in bytes (0 if unknown).
+ */
+size_t currentProcessRss();
+
+/**
+ * @brief Returns the peak resident set size of the process in bytes (0 if unknown).
+ */
+size_t peakProcessRss();
+
+#endif /* MemoryBudget_hpp */
@@ -0,0 +1,184 @@
+//
+//  ShotColumnStore.hpp
+//  Film_type_classifier
+//
+
+#ifndef ShotColumnStore_hpp
+#define ShotColumnStore_hpp
+
+#include <stdio.h>
+#include <fstream>
+#include <limits>
+#include <opencv2/opencv.hpp>
+#include "UserStructs.hpp"
+
+/**
+ * @struct ShotRecord
+ * @brief One shot, i.e. a run of consecutive frames classified as the same shot type.
+ */
+struct ShotRecord {
+    double start_ms = 0.;               ///< Timestamp of the first frame of the shot
+    double end_ms = 0.;                 ///< Timestamp of the last frame of the shot
+    ShotType type = ShotType::UNKNOWN;  ///< Shot type shared by all frames
+    double confidence = 0.;             ///< Mean probability of `type` over the frames
+    int face_count = 0;                 ///< Maximum number of faces in a frame of the shot
+    double largest_face_ratio = 0.;     ///< Maximum ratio of the largest face area to the frame area
+    int frame_count = 0;                ///< Number of frames in the shot
+};
+
+/**
+ * @struct ShotColumnChunk
+ * @brief Footer entry locating one chunk of a shot column file.
+ */
+struct ShotColumnChunk {
+    uint32_t rows = 0;                 ///< Rows in the chunk
+    double first_start_ms = 0.;        ///< start_ms of the first row
+    double last_start_ms = 0.;         ///< start_ms of the last row
+    std::vector<uint64_t> offsets;     ///< File offset of every column
+};
+
+/**
+ * @class ShotColumnWriter
+ * @brief Streams per-shot records into a self-describing column-chunked binary file.
+ *
+ * Frames are added in timestamp order; consecutive frames of the same shot type are
+ * merged into one ShotRecord. Records are buffered into chunks of `chunk_rows` rows
+ * and every chunk is written column by column, so a reader can load single columns
+ * without touching the others. Shot types are dictionary encoded (one byte per row).
+ *
+ * File layout (native little-endian):
+ * @code
+ *   "SHOTCOL1"
+ *   chunk 0: start_ms[f64] end_ms[f64] type[u8] confidence[f64] face_count[i32] largest_face_ratio[f64] frame_count[i32]
+ *   chunk 1: ...
+ *   footer:  u32 column count, per column: u8 name length, name, u8 value type
+ *            u32 dictionary size, per entry: u8 name length, shot type name
+ *            u32 chunk count, per chunk: u32 rows, f64 first start_ms, f64 last start_ms, u64 offset per column
+ *   u64 footer offset, "SHOTCOL1"
+ * @endcode
+ *
+ * The chunk table in the footer is the timestamp index: a time range query reads only
+ * the chunks whose start_ms range overlaps it. In a chunk only partly inside the range,
+ * the start_ms column is read as well to select the matching rows.
+ *
+ * Example usage:
+ * @code
+ *   ShotColumnWriter writer("film.shotcol");
+ *   writer.addFrame(timestamp, features, result); // for every frame
+ *   writer.finish();
+ * @endcode
+ *
+ * @see ShotColumnReader
+ */
+class ShotColumnWriter
+{
+    std::ofstream file;                         ///< Output file
+    size_t chunk_rows = 256;                    ///< Rows per chunk
+    std::vector<ShotRecord> chunk;              ///< Rows of the chunk being filled
+    std::vector<ShotType> dictionary;           ///< Shot types in order of first appearance
+    std::vector<ShotColumnChunk> chunk_index;   ///< Location of every written chunk
+    ShotRecord current;                         ///< Shot still being extended
+    double confidence_sum = 0.;                 ///< Sum of per-frame confidences of `current`
+    double last_ms = std::numeric_limits<double>::lowest(); ///< Timestamp of the last added frame
+    bool finished = false;                      ///< Set by finish()
+
+    uint8_t encode(ShotType type);
+    void closeShot();
+    void flushChunk();
+
+public:
+    /**
+     * @brief Creates the output file and writes the header.
+     * @param path Output file path.
+     * @param chunkRows Number of shots per column chunk (a feature film has a few thousand shots).
+     * @throws std::runtime_error if the file cannot be created.
+     */
+    explicit ShotColumnWriter(const std::string& path, size_t chunkRows = 256);
+
+    /**
+     * @brief Finishes the file if finish() was not called.
+     */
+    ~ShotColumnWriter();
+
+    /**
+     * @brief Adds one classified frame.
+     *
+     * @param timestampMs Timestamp of the frame; must not decrease between calls.
+     * @param features Shot features of the frame.
+     * @param result Classification result of the frame.
+     * @throws std::runtime_error if the timestamp is lower than the previous one.
+     */
+    void addFrame(double timestampMs, const ShotFeatures& features, const ClassificationResult& result);
+
+    /**
+     * @brief Closes the last shot, writes the footer and closes the file.
+     * @throws std::runtime_error if writing fails.
+     */
+    void finish();
+};
+
+/**
+ * @class ShotColumnReader
+ * @brief Reads single columns of a file written by ShotColumnWriter.
+ *
+ * Only the footer is read on construction; every read*() call loads just the requested
+ * column of the shots starting within the requested time range.
+ *
+ * @see ShotColumnWriter
+ */
+class ShotColumnReader
+{
+    mutable std::ifstream file;            ///< Input file
+    std::vector<std::string> column_names; ///< Column names in file order
+    std::vector<uint8_t> column_types;     ///< Value type per column
+    std::vector<ShotType> dictionary;      ///< Decoding table of the type column
+    std::vector<ShotColumnChunk> chunks;   ///< Chunk index from the footer
+
+    size_t columnIndex(const std::string& name, uint8_t valueType) const;
+    std::vector<char> readColumn(const std::string& name, uint8_t valueType, double startMs, double endMs) const;
+
+public:
+    /**
+     * @brief Opens the file and reads its footer.
+     * @param path File written by ShotColumnWriter.
+     * @throws std::runtime_error if the file is missing or not a shot column file.
+     */
+    explicit ShotColumnReader(const std::string& path);
+
+    /**
+     * @brief Returns the names of all stored columns.
+     */
+    const std::vector<std::string>& getColumnNames() const { return column_names; }
+
+    /**
+     * @brief Returns the total number of shots.
+     */
+    size_t getRowCount() const;
+
+    /**
+     * @brief Reads a floating point column (start_ms, end_ms, confidence, largest_face_ratio).
+     *
+     * @param name Column name.
+     * @param startMs Only shots starting at or after this time are returned.
+     * @param endMs Only shots starting at or before this time are returned.
+     * @return Column values of the shots starting in [startMs, endMs], in file order.
+     */
+    std::vector<double> readDoubleColumn(const std::string& name,
+                                         double startMs = -std::numeric_limits<double>::infinity(),
+                                         double endMs = std::numeric_limits<double>::infinity()) const;
+
+    /**
+     * @brief Reads an integer column (face_count, frame_count). See readDoubleColumn().
+     */
+    std::vector<int> readIntColumn(const std::string& name,
+                                   double startMs = -std::numeric_limits<double>::infinity(),
+                                   double endMs = std::numeric_limits<double>::infinity()) const;
+
+    /**
+     * @brief Reads and decodes the dictionary encoded shot type column. See readDoubleColumn().
+     */
+    std::vector<ShotType> readShotTypes(double startMs = -std::numeric_limits<double>::infinity(),
+                                        double endMs = std::numeric_limits<double>::infinity()) const;
+};
+
+#endif /* ShotColumnStore_hpp */
@@ -0,0 +1,187 @@
+//
+//  ShotPipeline.hpp
+//  Film_type_classifier
+//
+
+#ifndef ShotPipeline_hpp
+#define ShotPipeline_hpp
+
+#include <stdio.h>
+#include <opencv2/opencv.hpp>
+#include "UserStructs.hpp"
+#include "DetectorPool.hpp"
+#include "FeatureProccesorAndClassifier.hpp"
+#include "FileLoader.hpp"
+#include "FilmStatisticEval.hpp"
+#include "ShotColumnStore.hpp"
+#include "MemoryBudget.hpp"
+
+/**
+ * @class ShotPipeline
+ * @brief Runs the detection → feature extraction → classification dataflow for frames.
+ *
+ * The pipeline keeps no per-frame state: detectors are checked out of the shared
+ * DetectorPools for every call, so one pipeline can be used from several threads
+ * and processBatch() classifies frames in parallel.
+ *
+ * Frontal and profile detections are merged; a profile face overlapping a frontal
+ * one is treated as the same face.
+ *
+ * Before detection, a cheap pass over a downscaled frame (Preprocessing::ComputeGlobalFeatures())
+ * classifies black and credits frames directly and skips the detectors on frames that cannot
+ * contain a face.
+ *
+ * Example usage:
+ * @code
+ *   DetectorPool frontal_pool(frontal_path), profile_pool(profile_path);
+ *   ShotPipeline pipeline(frontal_pool, profile_pool);
+ *   VideoLoader video("film.mp4");
+ *   FilmStatistics stats;
+ *   pipeline.processSource(video, stats);
+ * @endcode
+ *
+ * @see DetectorPool
+ * @see ShotFeatureExtractor
+ * @see ShotClassifier
+ */
+class ShotPipeline
+{
+    DetectorPool& frontal_pool;          ///< Pool of frontal face detectors
+    DetectorPool& profile_pool;          ///< Pool of profile face detectors
+    ShotFeatureExtractor extractor;      ///< Stateless feature extractor
+    ShotClassifier classifier;           ///< Stateless shot classifier
+    size_t batch_size = 16;              ///< Number of frames processed in parallel by processSource()
+    int tile_max_face_size = 0;          ///< Max face size for tiled single-frame detection (0 = off)
+    bool prefilter_enabled = true;       ///< Skip detection on frames rejected by the pre-classification
+    MemoryBudget* memory_budget = nullptr; ///< Optional budget bounding the frames held by processSource()
+
+    std::vector<DetectedFeature> detectFaces(const cv::Mat& frame, bool tiled);
+    ClassificationResult classifyFrame(const cv::Mat& frame, ShotFeatures& features, bool tiled);
+
+public:
+    /**
+     * @brief Constructs the pipeline on top of already loaded detector pools.
+     * @param frontalPool Pool with the frontal face cascade.
+     * @param profilePool Pool with the profile face cascade.
+     */
+    ShotPipeline(DetectorPool& frontalPool, DetectorPool& profilePool)
+        : frontal_pool(frontalPool), profile_pool(profilePool) {}
+
+    ~ShotPipeline() = default;
+
+    /**
+     * @brief Sets how many frames processSource() reads and classifies at once.
+     * @param size Batch size (1 = process frames one by one on the calling thread).
+     */
+    void setBatchSize(size_t size) { batch_size = size > 0 ? size : 1; }
+
+    /**
+     * @brief Returns the batch size used by processSource().
+     */
+    size_t getBatchSize() const { return batch_size; }
+
+    /**
+     * @brief Enables tiled detection for frames classified one at a time.
+     *
+     * A single large still cannot use frame parallelism, so processFrame() and
+     * processImages() split it into tiles detected in parallel instead (see
+     * DetectorPool::detectTiled()). processBatch() and processSource() always detect
+     * on full frames, since they are already parallel.
+     *
+     * @param maxFaceSize Largest face (in pixels) that has to be detected; 0 disables tiling.
+     */
+    void setTiling(int maxFaceSize) { tile_max_face_size = maxFaceSize > 0 ? maxFaceSize : 0; }
+
+    /**
+     * @brief Returns the maximum face size used for tiling (0 = tiling disabled).
+     */
+    int getTiling() const { return tile_max_face_size; }
+
+    /**
+     * @brief Enables or disables the pre-classification stage (enabled by default).
+     * @param enabled False runs the detectors on every frame.
+     */
+    void setPrefilter(bool enabled) { prefilter_enabled = enabled; }
+
+    /**
+     * @brief Returns whether the pre-classification stage is enabled.
+     */
+    bool getPrefilter() const { return prefilter_enabled; }
+
+    /**
+     * @brief Bounds the frames processSource() holds at once by the FRAME_POOL share of a budget
+     *        and the detectors of both pools by its DETECTION_CACHE share.
+     *
+     * Batches end early when the next frame would exceed the limit (at least one frame is
+     * always processed). Call it while no frame is being classified.
+     *
+     * @param budget Budget to respect (nullptr = batches of `batch_size` frames, no detector limit).
+     */
+    void setMemoryBudget(MemoryBudget* budget);
+
+    /**
+     * @brief Returns the budget set with setMemoryBudget() (nullptr = unbounded).
+     */
+    MemoryBudget* getMemoryBudget() const { return memory_budget; }
+
+    /**
+     * @brief Builds detectors in both pools until each holds at least `count` (see DetectorPool::warmUp()).
+     * @param count Number of detectors per pool, e.g. the worker thread count.
+     */
+    void warmUp(size_t count);
+
+    /**
+     * @brief Detects faces in a frame and returns them merged and sorted by size.
+     * @param frame Input frame (BGR or grayscale).
+     */
+    std::vector<DetectedFeature> detect(const cv::Mat& frame);
+
+    /**
+     * @brief Classifies a single frame on the calling thread.
+     *
+     * @param frame Input frame (BGR or grayscale).
+     * @param features Output: shot features the classification was based on.
+     * @return Classification result of the frame.
+     */
+    ClassificationResult processFrame(const cv::Mat& frame, ShotFeatures& features);
+
+    /**
+     * @brief Classifies several frames in parallel.
+     *
+     * Results are returned in the order of the input frames and are identical
+     * to calling processFrame() for each frame with tiling disabled.
+     *
+     * @param frames Input frames.
+     * @param features Optional output: shot features per frame.
+     * @return Classification result per frame.
+     */
+    std::vector<ClassificationResult> processBatch(const std::vector<cv::Mat>& frames,
+                                                   std::vector<ShotFeatures>* features = nullptr);
+
+    /**
+     * @brief Classifies all frames of an input source and adds them to the statistics.
+     *
+     * Frames are read in batches of `batch_size` (or fewer, see setMemoryBudget()) and
+     * classified with processBatch(). Frames are never tiled, so the results do not depend
+     * on how the source is split into batches.
+     *
+     * @param source Image or video source.
+     * @param stats Statistics receiving one result per frame, in frame order.
+     * @param shotWriter Optional writer receiving features and result of every frame.
+     */
+    void processSource(InputSource& source, FilmStatistics& stats, ShotColumnWriter* shotWriter = nullptr);
+
+    /**
+     * @brief Classifies the stills of a source one by one with processFrame().
+     *
+     * Meant for a directory of large independent images: with tiling enabled each image
+     * is detected in parallel tiles, otherwise this is a sequential processSource().
+     *
+     * @param source Image source.
+     * @param stats Statistics receiving one result per image, in image order.
+     * @param shotWriter Optional writer receiving features and result of every image.
+     */
+    void processImages(InputSource& source, FilmStatistics& stats, ShotColumnWriter* shotWriter = nullptr);
+};
+
+#endif /* ShotPipeline_hpp */
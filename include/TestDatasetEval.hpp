@@ -12,9 +12,7 @@
 #include <opencv2/opencv.hpp>
 #include <iostream>
 #include "UserStructs.hpp"
-
-#endif /* TestDatasetEval_hpp */
-
+#include "ShotPipeline.hpp"
 
 /**
  * @class TestDatasetEval
@@ -63,3 +61,192 @@ public:
      */
     double GetEvalResult();
 };
+
+/**
+ * @struct ReplayReport
+ * @brief Outcome of a PipelineReplay run.
+ */
+struct ReplayReport {
+    size_t frame_count = 0;                         ///< Frames replayed per mode
+    bool identical = true;                          ///< All modes produced bit-identical results
+    std::vector<std::string> mismatches;            ///< Description of every differing frame
+    std::map<std::string, double> frames_per_second;///< Measured throughput per mode
+    std::map<std::string, double> baseline_fps;     ///< Stored throughput per mode (empty if recorded now)
+    bool throughput_ok = true;                      ///< No mode dropped below baseline * (1 - tolerance)
+    double accuracy = 0.;                           ///< Share of labeled images classified as their label
+    double tiling_speedup = 0.;                     ///< Full-frame over tiled detection time (checkTiling)
+    std::vector<std::string> failed_checks;         ///< Description of every failed component check
+
+    /**
+     * @brief True if results are identical, throughput did not regress and all checks passed.
+     */
+    bool passed() const { return identical && throughput_ok && failed_checks.empty(); }
+};
+
+/**
+ * @class PipelineReplay
+ * @brief Deterministic replay of a labeled corpus through the pipeline in every execution mode.
+ *
+ * The corpus is the labeled test images (`<dir>/<label>/<n>.jpg`, loaded with ImageLoader)
+ * plus a short video synthesized from them and read back with VideoLoader. Every frame is
+ * classified in three modes:
+ * - `single`:  one OpenCV thread, frames one by one (processFrame)
+ * - `threaded`: all OpenCV threads, frames one by one
+ * - `batched`: all OpenCV threads, the images and the video file through processSource(),
+ *   i.e. in parallel batches exactly as a classified film
+ *
+ * Shot features, classification results (including probabilities, compared bit for bit),
+ * the resulting FilmStatistics and the per-shot records written by a ShotColumnWriter (one file
+ * for the images and one for the video, whose timestamps start at 0 again) must be
+ * identical across modes. Every mode runs once to warm up and then several timed times; the
+ * median throughput is compared with a baseline file, which must exist (see `record`).
+ *
+ * Tiled detection is switched off during the replay, it is not bit-identical by design.
+ *
+ * Example usage:
+ * @code
+ *   PipelineReplay replay(pipeline);
+ *   replay.loadImageCorpus("test");
+ *   replay.addSynthesizedVideo("/tmp/replay.avi");
+ *   ReplayReport report = replay.run("test/throughput_baseline.txt", 0.2);
+ * @endcode
+ *
+ * @see ShotPipeline
+ */
+class PipelineReplay
+{
+    ShotPipeline& pipeline;              ///< Pipeline under test
+    std::vector<cv::Mat> frames;         ///< Replayed frames, images first
+    std::vector<std::string> frame_names;///< Source of every frame, used in mismatch messages
+    std::vector<double> timestamps;      ///< Timestamp of every frame (index for images, position in ms for video frames)
+    std::vector<ShotType> labels;        ///< Ground truth per frame (UNKNOWN for video frames)
+    size_t image_count = 0;              ///< Number of leading frames loaded from images
+    std::string video_path;              ///< Synthesized video, empty if there is none
+
+public:
+    /**
+     * @brief Constructs the replay around a pipeline.
+     * @param shotPipeline Pipeline to exercise.
+     */
+    explicit PipelineReplay(ShotPipeline& shotPipeline) : pipeline(shotPipeline) {}
+
+    /**
+     * @brief Loads all images of a labeled directory in a deterministic (sorted) order.
+     *
+     * @param testDir Directory with one subdirectory per label (closeup, medium, wide).
+     * @return Number of loaded images.
+     * @throws std::runtime_error if the directory does not exist.
+     */
+    size_t loadImageCorpus(const std::string& testDir);
+
+    /**
+     * @brief Writes the loaded images into a short video and adds its decoded frames.
+     *
+     * @param videoPath Path of the video to write (Motion JPEG AVI).
+     * @param framesPerImage How many consecutive video frames show each image.
+     * @return Number of added frames (0 if no video writer is available).
+     */
+    size_t addSynthesizedVideo(const std::string& videoPath, int framesPerImage = 3);
+
+    /**
+     * @brief Replays the corpus in all modes and compares results and throughput.
+     *
+     * The caller's tiling setting and OpenCV thread count are restored afterwards.
+     *
+     * @param baselinePath File with one "<mode> <frames per second>" line per mode ('#' starts a comment).
+     * @param tolerance Allowed relative throughput drop (e.g. 0.2 = 20 %).
+     * @param record Write the measured throughput to `baselinePath` instead of comparing with it,
+     *               together with the host name, core count and OpenCV version it was measured with.
+     * @param repetitions Number of timed passes per mode after the warm-up pass.
+     * @return Report of the run; a missing baseline is a failed check.
+     */
+    ReplayReport run(const std::string& baselinePath, double tolerance, bool record = false, int repetitions = 5);
+
+    /**
+     * @brief Runs a ClassificationServer on the pipeline and checks its protocol.
+     *
+     * IMAGE and BYTES requests must give the same shot type as processFrame(), invalid
+     * requests must be answered with ERROR, a server with full queues with BUSY, and
+     * A VIDEO request must give the same statistics as classifying the frames one by one.
+     * A connection beyond `max_connections` must get BUSY, and the slot must be freed again
+     * once a client disconnects.
+     * A BYTES payload that does not fit the LOADER_QUEUE budget must get BUSY and be skipped,
+     * so the next request on the same connection is served, and an accepted payload must be
+     * released from the budget once answered.
+     * SHUTDOWN must make run() return. start() must refuse to replace a file that is not
+     * a socket. Needs the image corpus to be loaded.
+     *
+     * @param socketPath Path for the temporary server socket.
+     * @param report Report receiving the failed checks.
+     */
+    void checkServer(const std::string& socketPath, ReplayReport& report);
+
+    /**
+     * @brief Compares tiled with full-frame detection on upscaled test images.
+     *
+     * Asserts the tolerance documented in DetectorPool::detectTiled(): the largest face of
+     * every image and at least 90 % of all full-frame faces are found with IoU >= 0.5. The
+     * maximum face size is a quarter of the shorter image side, so close-ups also exercise the
+     * large-face pass. The pipeline's tiling setting is restored afterwards.
+     *
+     * Both detections are timed over all images (median of 3 runs) and the speed-up is stored
+     * in the report. With at least 4 threads and cores, tiling must be at least 1.5× faster.
+     *
+     * @param report Report receiving the failed checks.
+     * @param upscale Factor the test images are enlarged by.
+     */
+    void checkTiling(ReplayReport& report, double upscale = 3.);
+
+    /**
+     * @brief Compares the cold start of a DetectorPool on all threads with a single-threaded one.
+     *
+     * Both parse the model into a new pool; the multi-threaded start then holds one detector
+     * per OpenCV thread (at most one per core) at once, as the first batch does. Its median
+     * time must stay within twice the single-threaded one. Skipped on a single core.
+     *
+     * @param modelPath Haar cascade XML file to load.
+     * @param report Report receiving the failed checks.
+     */
+    void checkStartup(const std::string& modelPath, ReplayReport& report);
+
+    /**
+     * @brief Checks that the pre-classification never changes a result.
+     *
+     * Every loaded test image must get the same shot type with the prefilter enabled as with
+     * the detectors run on every frame. The caller's prefilter setting is restored.
+     *
+     * @param report Report receiving the failed checks.
+     */
+    void checkPrefilter(ReplayReport& report);
+
+    /**
+     * @brief Writes synthetic shots to a shot column file and reads them back.
+     *
+     * The file spans several small chunks; every column, the type dictionary and time
+     * range reads (across chunk boundaries, partly covered chunks, empty ranges) must
+     * return exactly the records expected from the writer's shot merging. A frame with a
+     * timestamp lower than the previous one must be rejected.
+     *
+     * @param path Path of the temporary column file.
+     * @param report Report receiving the failed checks.
+     */
+    void checkShotColumnStore(const std::string& path, ReplayReport& report);
+
+    /**
+     * @brief Classifies the corpus under a tiny MemoryBudget and compares with an unbounded run.
+     *
+     * The images and the video go through processSource() with a frame pool of two frames,
+     * a statistics share of a few timeline entries and no room for idle detectors, so batches
+     * shrink, the timeline is spilled to disk many times and the detector pools, warmed up to
+     * several detectors, evict down to one detector each. Statistics, timeline and shot records must equal the unbounded run.
+     * A copy of the statistics taken between the images and the video must keep its timeline
+     * while the original spills again (copy-on-write of the spill file). The pipeline's
+     * budget is restored afterwards.
+     *
+     * @param shotPath Path of the temporary shot column files (a second one gets ".bounded" appended).
+     * @param report Report receiving the failed checks.
+     */
+    void checkMemoryBudget(const std::string& shotPath, ReplayReport& report);
+};
+
+#endif /* TestDatasetEval_hpp */
@@ -24,6 +24,38 @@ struct DetectedFeature {
     cv::Rect boundingBox; ///< Bounding box of the detected object in image coordinates
 };
 
+/**
+ * @enum FrameContent
+ * @brief Result of the cheap global pre-classification of a frame.
+ *
+ * Frames other than REGULAR are not passed to the Haar detectors.
+ */
+enum class FrameContent {
+    REGULAR,    ///< Frame may contain a relevant face, run the detectors
+    BLACK,      ///< (Almost) black frame, e.g. fade or gap between scenes
+    CREDITS,    ///< Bright text on a dark background
+    NO_FACE     ///< Frame cannot contain a face of the minimal detector size
+};
+
+/**
+ * @struct GlobalFrameFeatures
+ * @brief Whole-frame statistics computed on a downscaled frame before face detection.
+ *
+ * Unless noted otherwise, ratios are fractions of the pixels of the downscaled frame.
+ */
+struct GlobalFrameFeatures {
+    double mean_luma = 0.;      ///< Mean luminance (0-255)
+    double luma_stddev = 0.;    ///< Standard deviation of the luminance
+    double dark_ratio = 0.;     ///< Pixels with luminance below 40
+    double bright_ratio = 0.;   ///< Pixels with luminance above 180
+    double edge_density = 0.;   ///< Pixels with a strong horizontal or vertical luminance step
+    double skin_ratio = 0.;     ///< Pixels within the YCrCb skin tone range
+    double chroma_ratio = 0.;   ///< Pixels with noticeable colour (low for black-and-white footage)
+    double stroke_ratio = 0.;   ///< Share of horizontal runs of bright pixels that are at most 8 pixels long
+    double text_row_ratio = 0.; ///< Rows containing at least one bright pixel
+    double frame_area = 0.;     ///< Area of the original (not downscaled) frame
+};
+
 /**
  * @struct ShotFeatures
  * @brief Represents extracted geometric and area-based properties from a video frame.
@@ -43,6 +75,8 @@ struct ShotFeatures {
 
     // for good shot classification + we can add some statistical metrics
     std::vector<cv::Point2f> object_centers; ///< Center points of detected objects, ordered by size
+
+    FrameContent content = FrameContent::REGULAR; ///< Result of the pre-classification
 };
 
 /**
@@ -55,9 +89,23 @@ enum class ShotType {
     CLOSE_UP,   ///< A close-up shot, typically a large face
     MEDIUM,     ///< A medium shot, e.g., upper body
     WIDE,       ///< A wide shot, showing full figures or environment
+    BLACK,      ///< A black frame (fade, scene gap)
+    CREDITS,    ///< Titles or credits
     UNKNOWN     ///< Could not determine shot type
 };
 
+/**
+ * @brief Returns a printable name of the shot type (e.g. "CLOSE_UP").
+ * @param type Shot type to convert.
+ */
+std::string shotTypeToString(ShotType type);
+
+/**
+ * @brief Parses a name produced by shotTypeToString().
+ * @param name Shot type name; unknown names map to ShotType::UNKNOWN.
+ */
+ShotType shotTypeFromString(const std::string& name);
+
 /**
  * @struct ClassificationResult
  * @brief Contains the result of shot type classification.
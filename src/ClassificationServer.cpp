@@ -0,0 +1,561 @@
+//
+//  ClassificationServer.cpp
+//  Film_type_classifier
+//
+
+#include "ClassificationServer.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sstream>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+    constexpr size_t kReadChunk = 64 * 1024;
+    constexpr size_t kMaxLineLength = 4096;
+
+    sockaddr_un socketAddress(const std::string& path) {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(address.sun_path)) {
+            throw std::runtime_error("Socket path too long: " + path);
+        }
+        std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+        return address;
+    }
+
+    bool writeAll(int fd, const char* data, size_t size) {
+        while (size > 0) {
+            ssize_t written = ::write(fd, data, size);
+            if (written < 0 && errno == EINTR) {
+                continue;
+            }
+            if (written <= 0) {
+                return false;
+            }
+            data += written;
+            size -= (size_t)written;
+        }
+        return true;
+    }
+
+    bool fillBuffer(int fd, std::string& buffer) {
+        char chunk[kReadChunk];
+        while (true) {
+            ssize_t received = ::read(fd, chunk, sizeof(chunk));
+            if (received < 0 && errno == EINTR) {
+                continue;
+            }
+            if (received <= 0) {
+                return false;
+            }
+            buffer.append(chunk, (size_t)received);
+            return true;
+        }
+    }
+
+    // Reads one '\n' terminated line; `buffer` keeps bytes received after it
+    bool readLine(int fd, std::string& buffer, std::string& line) {
+        size_t end;
+        while ((end = buffer.find('\n')) == std::string::npos) {
+            if (buffer.size() > kMaxLineLength || !fillBuffer(fd, buffer)) {
+                return false;
+            }
+        }
+        line = buffer.substr(0, end);
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        buffer.erase(0, end + 1);
+        return true;
+    }
+
+    bool readExact(int fd, std::string& buffer, size_t size, std::vector<uchar>& out) {
+        while (buffer.size() < size) {
+            if (!fillBuffer(fd, buffer)) {
+                return false;
+            }
+        }
+        out.assign(buffer.begin(), buffer.begin() + size);
+        buffer.erase(0, size);
+        return true;
+    }
+
+    // Discards the next `size` bytes of the stream without holding more than one read chunk
+    bool skipExact(int fd, std::string& buffer, size_t size) {
+        while (buffer.size() < size) {
+            size -= buffer.size();
+            buffer.clear();
+            if (!fillBuffer(fd, buffer)) {
+                return false;
+            }
+        }
+        buffer.erase(0, size);
+        return true;
+    }
+
+    std::string formatResult(ShotType type, double confidence, const FilmStatistics& stats) {
+        std::ostringstream response;
+        response << "OK " << shotTypeToString(type) << ' ' << confidence << " frames=" << stats.getAnalyzedFrames();
+        for (ShotType counted : {ShotType::CLOSE_UP, ShotType::MEDIUM, ShotType::WIDE,
+                                 ShotType::BLACK, ShotType::CREDITS, ShotType::UNKNOWN}) {
+            auto it = stats.getShotCounts().find(counted);
+            response << ' ' << shotTypeToString(counted) << '=' << (it != stats.getShotCounts().end() ? it->second : 0);
+        }
+        return response.str();
+    }
+}
+
+ClassificationServer::~ClassificationServer()
+{
+    stop();
+}
+
+void ClassificationServer::start(const std::string& path)
+{
+    // A client closing its socket early must not kill the server
+    std::signal(SIGPIPE, SIG_IGN);
+
+    sockaddr_un address = socketAddress(path);
+
+    // Only a stale socket of an earlier run is replaced, never a regular file given by mistake
+    struct stat existing{};
+    if (::lstat(path.c_str(), &existing) == 0) {
+        if (!S_ISSOCK(existing.st_mode)) {
+            throw std::runtime_error("Refusing to replace " + path + ": file exists and is not a socket");
+        }
+        ::unlink(path.c_str());
+    }
+
+    listen_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        throw std::runtime_error("Failed to create socket: " + std::string(std::strerror(errno)));
+    }
+    // Non-blocking, so a connection reset between poll() and accept() cannot block run()
+    if (::bind(listen_fd, (sockaddr*)&address, sizeof(address)) < 0 ||
+        ::listen(listen_fd, SOMAXCONN) < 0 ||
+        ::fcntl(listen_fd, F_SETFL, ::fcntl(listen_fd, F_GETFL) | O_NONBLOCK) < 0 ||
+        ::pipe(wake_pipe) < 0) {
+        std::string error = std::strerror(errno);
+        ::close(listen_fd);
+        listen_fd = -1;
+        throw std::runtime_error("Failed to listen on " + path + ": " + error);
+    }
+    socket_path = path;
+    // A full pipe already wakes run(), so writers never need to block
+    ::fcntl(wake_pipe[1], F_SETFL, ::fcntl(wake_pipe[1], F_GETFL) | O_NONBLOCK);
+
+    for (size_t i = 0; i < std::max<size_t>(options.worker_count, 1); i++) {
+        workers.emplace_back(&ClassificationServer::workerLoop, this, std::ref(image_queue), options.max_batch);
+    }
+    for (size_t i = 0; i < std::max<size_t>(options.video_worker_count, 1); i++) {
+        workers.emplace_back(&ClassificationServer::workerLoop, this, std::ref(video_queue), (size_t)1);
+    }
+}
+
+void ClassificationServer::run()
+{
+    {
+        // stop() closes listen_fd only after this loop has left it
+        std::lock_guard<std::mutex> run_lock(run_mutex);
+        pollfd watched[2] = {{listen_fd, POLLIN, 0}, {wake_pipe[0], POLLIN, 0}};
+        while (listen_fd >= 0 && !stopping) {
+            if (::poll(watched, 2, -1) < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                break;
+            }
+            if (watched[1].revents != 0) {
+                break; // woken by stop() or a SHUTDOWN request
+            }
+            if (watched[0].revents == 0) {
+                continue;
+            }
+
+            int client_fd = ::accept(listen_fd, nullptr, nullptr);
+            if (client_fd < 0) {
+                if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK || errno == ECONNABORTED) {
+                    continue;
+                }
+                break;
+            }
+            // BSD sockets inherit O_NONBLOCK from the listening socket, connections use blocking I/O
+            ::fcntl(client_fd, F_SETFL, ::fcntl(client_fd, F_GETFL) & ~O_NONBLOCK);
+
+            reapConnections();
+            std::lock_guard<std::mutex> lock(connection_mutex);
+            if (stopping) {
+                ::close(client_fd);
+                break;
+            }
+            // Each connection holds a thread, so idle or slow clients beyond the limit are turned away
+            if (connections.size() >= options.max_connections) {
+                const std::string busy = "BUSY\n";
+                (void)writeAll(client_fd, busy.data(), busy.size());
+                ::close(client_fd);
+                rejected_count++;
+                continue;
+            }
+            Connection& connection = connections.emplace_back();
+            connection.fd = client_fd;
+            connection.thread = std::thread(&ClassificationServer::handleConnection, this, &connection);
+        }
+    }
+    stop();
+}
+
+void ClassificationServer::reapConnections()
+{
+    std::vector<std::thread> finished;
+    {
+        std::lock_guard<std::mutex> lock(connection_mutex);
+        for (auto it = connections.begin(); it != connections.end();) {
+            if (it->finished) {
+                finished.push_back(std::move(it->thread));
+                it = connections.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    // The threads have already left handleConnection(), joining does not wait for a client
+    for (std::thread& thread : finished) {
+        thread.join();
+    }
+}
+
+void ClassificationServer::wakeAcceptLoop()
+{
+    const char byte = 1;
+    if (wake_pipe[1] >= 0) {
+        (void)!::write(wake_pipe[1], &byte, 1);
+    }
+}
+
+void ClassificationServer::stop()
+{
+    std::call_once(stop_once, [this]() {
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            stopping = true;
+        }
+        image_queue.ready.notify_all();
+        video_queue.ready.notify_all();
+
+        // shutdown() does not wake accept() on every platform, the self-pipe does
+        wakeAcceptLoop();
+        {
+            std::lock_guard<std::mutex> run_lock(run_mutex);
+            if (listen_fd >= 0) {
+                ::close(listen_fd);
+                listen_fd = -1;
+                ::unlink(socket_path.c_str());
+            }
+        }
+
+        // Workers drain the queues before exiting, so no connection waits forever
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+
+        std::vector<std::thread> threads;
+        {
+            std::lock_guard<std::mutex> lock(connection_mutex);
+            for (Connection& connection : connections) {
+                if (!connection.finished) {
+                    ::shutdown(connection.fd, SHUT_RDWR);
+                }
+                threads.push_back(std::move(connection.thread));
+            }
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        connections.clear();
+
+        for (int& fd : wake_pipe) {
+            if (fd >= 0) {
+                ::close(fd);
+                fd = -1;
+            }
+        }
+    });
+}
+
+void ClassificationServer::handleConnection(Connection* connection)
+{
+    const int fd = connection->fd;
+    std::string buffer;
+    std::string line;
+    bool keep_open = true;
+
+    while (keep_open && readLine(fd, buffer, line)) {
+        if (line.empty()) {
+            continue;
+        }
+        std::string response = handleRequest(fd, line, buffer, keep_open) + "\n";
+        if (!writeAll(fd, response.data(), response.size())) {
+            break;
+        }
+        if (line == "SHUTDOWN") {
+            wakeAcceptLoop(); // run() leaves the accept loop and stops the server
+        }
+    }
+
+    // Marked under the lock together with closing, so stop() never shuts down a reused descriptor
+    std::lock_guard<std::mutex> lock(connection_mutex);
+    ::close(fd);
+    connection->finished = true;
+}
+
+std::string ClassificationServer::handleRequest(int fd, const std::string& line, std::string& buffer, bool& keepOpen)
+{
+    std::istringstream request(line);
+    auto job = std::make_unique<Job>();
+    request >> job->command;
+
+    if (job->command == "STATS") {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        std::ostringstream response;
+        response << "OK served=" << served_count << " rejected=" << rejected_count
+                 << " failed=" << failed_count << " queued=" << image_queue.jobs.size()
+                 << " videos_queued=" << video_queue.jobs.size();
+        return response.str();
+    }
+    if (job->command == "SHUTDOWN") {
+        keepOpen = false; // handleConnection() wakes run() once the response is sent
+        return "OK shutdown";
+    }
+    if (job->command == "IMAGE") {
+        std::getline(request >> std::ws, job->path);
+    } else if (job->command == "VIDEO") {
+        request >> job->start_ms >> job->end_ms;
+        std::getline(request >> std::ws, job->path);
+    } else if (job->command == "BYTES") {
+        size_t size = 0;
+        if (!(request >> size) || size == 0 || size > options.max_payload_bytes) {
+            // An invalid size cannot be trusted to delimit the payload, so the connection is dropped
+            keepOpen = false;
+            failed_count++;
+            return "ERROR invalid payload size";
+        }
+        if (memory_budget) {
+            // Reserved before reading. A payload that does not fit next to the payloads already
+            // held is refused; when nothing is held, one payload up to max_payload_bytes is
+            // accepted even if it is larger than the whole share, so it can still be classified.
+            bool fits = true;
+            {
+                std::lock_guard<std::mutex> lock(queue_mutex);
+                fits = memory_budget->getCurrent(MemoryComponent::LOADER_QUEUE) == 0 ||
+                       memory_budget->fits(MemoryComponent::LOADER_QUEUE, size);
+                if (fits) {
+                    memory_budget->add(MemoryComponent::LOADER_QUEUE, (long long)size);
+                } else {
+                    rejected_count++;
+                }
+            }
+            if (!fits) {
+                // The refused payload is read and dropped chunk by chunk, the connection stays usable
+                keepOpen = skipExact(fd, buffer, size);
+                return "BUSY";
+            }
+        }
+        if (!readExact(fd, buffer, size, job->payload)) {
+            if (memory_budget) {
+                memory_budget->add(MemoryComponent::LOADER_QUEUE, -(long long)size);
+            }
+            keepOpen = false;
+            return "ERROR incomplete payload";
+        }
+    } else {
+        failed_count++;
+        return "ERROR unknown command: " + job->command;
+    }
+
+    if (job->command != "BYTES" && job->path.empty()) {
+        failed_count++;
+        return "ERROR missing path";
+    }
+    return enqueue(std::move(job));
+}
+
+std::string ClassificationServer::enqueue(std::unique_ptr<Job> job)
+{
+    std::future<std::string> response = job->response.get_future();
+    JobQueue& queue = job->command == "VIDEO" ? video_queue : image_queue;
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        const bool rejected = stopping || queue.jobs.size() >= queue.capacity;
+        if (rejected && memory_budget) {
+            // The payload was reserved in handleRequest(), the worker releases it otherwise
+            memory_budget->add(MemoryComponent::LOADER_QUEUE, -(long long)job->payload.size());
+        }
+        if (stopping) {
+            return "ERROR server is stopping";
+        }
+        if (rejected) {
+            rejected_count++;
+            return "BUSY";
+        }
+        queue.jobs.push_back(std::move(job));
+    }
+    queue.ready.notify_one();
+    return response.get();
+}
+
+void ClassificationServer::workerLoop(JobQueue& queue, size_t maxBatch)
+{
+    while (true) {
+        std::vector<std::unique_ptr<Job>> jobs;
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            queue.ready.wait(lock, [&]() { return stopping || !queue.jobs.empty(); });
+            if (queue.jobs.empty()) {
+                return; // stopping and nothing left to answer
+            }
+            while (!queue.jobs.empty() && jobs.size() < std::max<size_t>(maxBatch, 1)) {
+                jobs.push_back(std::move(queue.jobs.front()));
+                queue.jobs.pop_front();
+                if (memory_budget) {
+                    memory_budget->add(MemoryComponent::LOADER_QUEUE, -(long long)jobs.back()->payload.size());
+                }
+            }
+        }
+        processJobs(jobs);
+    }
+}
+
+void ClassificationServer::processJobs(std::vector<std::unique_ptr<Job>>& jobs)
+{
+    // Still images of the whole batch are classified together in parallel
+    std::vector<cv::Mat> frames;
+    std::vector<Job*> frame_jobs;
+
+    for (auto& job : jobs) {
+        try {
+            if (job->command == "VIDEO") {
+                VideoLoader video(job->path, job->start_ms, job->end_ms);
+                FilmStatistics stats;
+                stats.setMemoryBudget(memory_budget);
+                pipeline.processSource(video, stats);
+                const int analyzed = stats.getAnalyzedFrames();
+                const ShotType dominant = stats.getDominantShotType();
+                const double share = analyzed > 0 ? (double)stats.getShotCounts().at(dominant) / analyzed : 0.;
+                // Counted before answering, so a STATS request sent after the answer sees it
+                served_count++;
+                job->response.set_value(formatResult(dominant, share, stats));
+                continue;
+            }
+
+            cv::Mat frame = job->command == "IMAGE" ? cv::imread(job->path, cv::IMREAD_COLOR)
+                                                     : cv::imdecode(job->payload, cv::IMREAD_COLOR);
+            if (frame.empty()) {
+                throw std::runtime_error("cannot decode image " + (job->command == "IMAGE" ? job->path : "payload"));
+            }
+            job->payload.clear();
+            frames.push_back(frame);
+            frame_jobs.push_back(job.get());
+
+            // Decoded frames are classified early once the frame pool is full
+            const size_t frame_bytes = frame.total() * frame.elemSize();
+            if (memory_budget) {
+                memory_budget->add(MemoryComponent::FRAME_POOL, (long long)frame_bytes);
+                if (!memory_budget->fits(MemoryComponent::FRAME_POOL, frame_bytes)) {
+                    classifyFrames(frames, frame_jobs);
+                }
+            }
+        } catch (const std::exception& e) {
+            failed_count++;
+            job->response.set_value(std::string("ERROR ") + e.what());
+        }
+    }
+
+    classifyFrames(frames, frame_jobs);
+}
+
+void ClassificationServer::classifyFrames(std::vector<cv::Mat>& frames, std::vector<Job*>& frameJobs)
+{
+    if (frames.empty()) {
+        return;
+    }
+
+    size_t answered = 0;
+    try {
+        // With tiling every still is detected in parallel tiles, one after another, so an
+        // answer does not depend on which requests happened to be batched together
+        std::vector<ClassificationResult> results;
+        if (pipeline.getTiling() > 0) {
+            ShotFeatures features;
+            for (const cv::Mat& frame : frames) {
+                results.push_back(pipeline.processFrame(frame, features));
+            }
+        } else {
+            results = pipeline.processBatch(frames);
+        }
+        for (size_t i = 0; i < results.size(); i++) {
+            FilmStatistics stats;
+            stats.addFrameResult(0., results[i]);
+            auto it = results[i].probabilities.find(results[i].predictedType);
+            const double confidence = it != results[i].probabilities.end() ? it->second : 0.;
+            served_count++;
+            frameJobs[i]->response.set_value(formatResult(results[i].predictedType, confidence, stats));
+            answered++;
+        }
+    } catch (const std::exception& e) {
+        for (size_t i = answered; i < frameJobs.size(); i++) {
+            failed_count++;
+            frameJobs[i]->response.set_value(std::string("ERROR ") + e.what());
+        }
+    }
+
+    if (memory_budget) {
+        for (const cv::Mat& frame : frames) {
+            memory_budget->add(MemoryComponent::FRAME_POOL, -(long long)(frame.total() * frame.elemSize()));
+        }
+    }
+    frames.clear();
+    frameJobs.clear();
+}
+
+ClassificationClient::ClassificationClient(const std::string& path)
+{
+    // A server closing the connection (e.g. over its connection limit) must not kill the client
+    std::signal(SIGPIPE, SIG_IGN);
+
+    sockaddr_un address = socketAddress(path);
+    fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || ::connect(fd, (sockaddr*)&address, sizeof(address)) < 0) {
+        std::string error = std::strerror(errno);
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        throw std::runtime_error("Failed to connect to " + path + ": " + error);
+    }
+}
+
+ClassificationClient::~ClassificationClient()
+{
+    if (fd >= 0) {
+        ::close(fd);
+    }
+}
+
+std::string ClassificationClient::request(const std::string& line, const std::vector<uchar>& payload)
+{
+    std::string message = line + "\n";
+    const bool sent = writeAll(fd, message.data(), message.size()) &&
+                      (payload.empty() || writeAll(fd, (const char*)payload.data(), payload.size()));
+    // A server that closed the connection early may still have left an answer (BUSY) to read
+    std::string response;
+    if (!readLine(fd, buffer, response)) {
+        throw std::runtime_error(sent ? "Connection closed by server" : "Failed to send request");
+    }
+    return response;
+}
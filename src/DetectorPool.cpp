@@ -0,0 +1,245 @@
+//
+//  DetectorPool.cpp
+//  Film_type_classifier
+//
+
+#include "DetectorPool.hpp"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+namespace {
+    // Duplicate detections of one face at a tile seam either overlap strongly or
+    // one of them (a face cut by the tile border) lies mostly inside the other
+    bool isSameFace(const cv::Rect& a, const cv::Rect& b, double threshold) {
+        const double intersection = (a & b).area();
+        if (intersection <= 0.) {
+            return false;
+        }
+        const double union_area = a.area() + b.area() - intersection;
+        const double smaller_area = std::min(a.area(), b.area());
+        return intersection / union_area > threshold || intersection / smaller_area > 1. - threshold / 2.;
+    }
+
+    // Splits the frame into at most `count` tiles of at least `minSide` pixels, overlapping by `minSide`
+    std::vector<cv::Rect> makeTiles(const cv::Size& frame, int count, int minSide) {
+        const double aspect = (double)frame.width / frame.height;
+        const int max_columns = std::max(1, std::min(count, frame.width / minSide));
+        const int columns = std::clamp((int)std::lround(std::sqrt(count * aspect)), 1, max_columns);
+        const int rows = std::clamp(count / columns, 1, std::max(1, frame.height / minSide));
+        const int stride_x = (frame.width + columns - 1) / columns;
+        const int stride_y = (frame.height + rows - 1) / rows;
+
+        std::vector<cv::Rect> tiles;
+        for (int y = 0; y < frame.height; y += stride_y) {
+            for (int x = 0; x < frame.width; x += stride_x) {
+                const int width = std::min(stride_x + minSide, frame.width - x);
+                const int height = std::min(stride_y + minSide, frame.height - y);
+                tiles.emplace_back(x, y, width, height);
+            }
+        }
+        return tiles;
+    }
+}
+
+void DetectorPool::loadModel(const std::string& modelPath) {
+    std::ifstream file(modelPath, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Failed to load Haar cascade from: " + modelPath);
+    }
+    std::ostringstream content;
+    content << file.rdbuf();
+    loadModelFromMemory(content.str());
+}
+
+void DetectorPool::loadModelFromMemory(const std::string& modelBuffer) {
+    reset();
+    model = parseCascadeModel(modelBuffer);
+
+    // Build the first detector right away so an invalid model fails here and not in a worker
+    std::unique_ptr<FeatureDetector> detector = createDetector();
+    std::lock_guard<std::mutex> lock(pool_mutex);
+    created_count = 1;
+    idle_detectors.push_back(std::move(detector));
+}
+
+DetectorPool::~DetectorPool() {
+    reset();
+}
+
+void DetectorPool::reset() {
+    std::lock_guard<std::mutex> lock(pool_mutex);
+    if (memory_budget) {
+        memory_budget->add(MemoryComponent::DETECTION_CACHE, -detectorBytes() * (long long)idle_detectors.size());
+    }
+    idle_detectors.clear();
+    created_count = 0;
+}
+
+void DetectorPool::setMemoryBudget(MemoryBudget* budget) {
+    std::lock_guard<std::mutex> lock(pool_mutex);
+    // Only idle detectors move between budgets, so the budget is switched between runs
+    const long long idle_bytes = detectorBytes() * (long long)idle_detectors.size();
+    if (memory_budget) {
+        memory_budget->add(MemoryComponent::DETECTION_CACHE, -idle_bytes);
+    }
+    if (budget) {
+        budget->add(MemoryComponent::DETECTION_CACHE, idle_bytes);
+    }
+    memory_budget = budget;
+}
+
+long long DetectorPool::detectorBytes() const {
+    return model ? (long long)model->source_bytes : 0;
+}
+
+std::unique_ptr<FeatureDetector> DetectorPool::createDetector() const {
+    auto detector = std::make_unique<FeatureDetector>();
+    detector->loadModel(model);
+    if (memory_budget) {
+        memory_budget->add(MemoryComponent::DETECTION_CACHE, detectorBytes());
+    }
+    return detector;
+}
+
+void DetectorPool::release(std::unique_ptr<FeatureDetector> detector) {
+    std::lock_guard<std::mutex> lock(pool_mutex);
+    // The last detector of the pool is kept, otherwise every frame would build one again
+    if (memory_budget && created_count > 1 &&
+        memory_budget->getCurrent(MemoryComponent::DETECTION_CACHE) >
+            memory_budget->getLimit(MemoryComponent::DETECTION_CACHE)) {
+        memory_budget->add(MemoryComponent::DETECTION_CACHE, -detectorBytes());
+        created_count--;
+        return; // detector is destroyed, the next checkout builds a new one
+    }
+    idle_detectors.push_back(std::move(detector));
+}
+
+DetectorPool::Lease DetectorPool::checkout() {
+    {
+        std::lock_guard<std::mutex> lock(pool_mutex);
+        if (!idle_detectors.empty()) {
+            std::unique_ptr<FeatureDetector> detector = std::move(idle_detectors.back());
+            idle_detectors.pop_back();
+            return Lease(this, std::move(detector));
+        }
+        created_count++;
+    }
+    // Build outside the pool lock, detectors being returned meanwhile need not wait
+    return Lease(this, createDetector());
+}
+
+std::vector<DetectedFeature> DetectorPool::detectTiled(const cv::Mat& gray, int maxFaceSize, double nmsThreshold) {
+    // Tiling pays off only if the frame holds several tiles of the maximum face size
+    const int thread_count = cv::getNumThreads();
+    if (maxFaceSize <= 0 || thread_count <= 1 || gray.cols < 2 * maxFaceSize || gray.rows < 2 * maxFaceSize) {
+        Lease detector = checkout();
+        return detector->detect(gray);
+    }
+    const std::vector<cv::Rect> tiles = makeTiles(gray.size(), thread_count, maxFaceSize);
+
+    // Task 0 finds faces too large for a tile on the full frame. Its minimum size leaves
+    // only the few coarsest scales, so it costs a fraction of a full-frame detection.
+    const cv::Size max_face(maxFaceSize, maxFaceSize);
+    std::vector<std::vector<cv::Rect>> tile_faces(tiles.size() + 1);
+    std::string label;
+    cv::parallel_for_(cv::Range(0, (int)tiles.size() + 1), [&](const cv::Range& range) {
+        // cv::CascadeClassifier is not thread-safe, every task uses its own pooled detector
+        Lease detector = checkout();
+        for (int i = range.start; i < range.end; i++) {
+            if (i == 0) {
+                tile_faces[0] = detector->detectFaces(gray, max_face);
+                label = detector->getLabel();
+                continue;
+            }
+            const cv::Rect& tile = tiles[i - 1];
+            tile_faces[i] = detector->detectFaces(gray(tile), FeatureDetector::getMinFaceSize(), max_face);
+            for (cv::Rect& face : tile_faces[i]) {
+                face.x += tile.x;
+                face.y += tile.y;
+            }
+        }
+    }, (double)tiles.size() + 1);
+
+    // Non-maximum suppression over all tiles and the large-face pass, larger boxes win;
+    // the total order keeps the winner among equal areas independent of the tile layout
+    std::vector<cv::Rect> candidates;
+    for (const std::vector<cv::Rect>& found : tile_faces) {
+        candidates.insert(candidates.end(), found.begin(), found.end());
+    }
+    std::sort(candidates.begin(), candidates.end(), isBiggerFace);
+
+    std::vector<cv::Rect> faces;
+    for (const cv::Rect& candidate : candidates) {
+        bool duplicate = false;
+        for (const cv::Rect& kept : faces) {
+            if (isSameFace(candidate, kept, nmsThreshold)) {
+                duplicate = true;
+                break;
+            }
+        }
+        if (!duplicate) {
+            faces.push_back(candidate);
+        }
+    }
+
+    std::vector<DetectedFeature> detected;
+    detected.reserve(faces.size());
+    for (const cv::Rect& face : faces) {
+        detected.push_back({label, face});
+    }
+    return detected;
+}
+
+void DetectorPool::warmUp(size_t count) {
+    size_t missing = 0;
+    {
+        std::lock_guard<std::mutex> lock(pool_mutex);
+        if (count <= created_count) {
+            return;
+        }
+        missing = count - created_count;
+        if (memory_budget) {
+            const size_t used = memory_budget->getCurrent(MemoryComponent::DETECTION_CACHE);
+            const size_t limit = memory_budget->getLimit(MemoryComponent::DETECTION_CACHE);
+            const size_t affordable = used < limit ? (limit - used) / std::max<long long>(detectorBytes(), 1) : 0;
+            missing = std::min(missing, affordable);
+        }
+        created_count += missing;
+    }
+
+    std::vector<std::unique_ptr<FeatureDetector>> built(missing);
+    cv::parallel_for_(cv::Range(0, (int)missing), [&](const cv::Range& range) {
+        for (int i = range.start; i < range.end; i++) {
+            built[i] = createDetector();
+        }
+    });
+
+    std::lock_guard<std::mutex> lock(pool_mutex);
+    for (auto& detector : built) {
+        idle_detectors.push_back(std::move(detector));
+    }
+}
+
+size_t DetectorPool::size() {
+    std::lock_guard<std::mutex> lock(pool_mutex);
+    return created_count;
+}
+
+DetectorPool::Lease& DetectorPool::Lease::operator=(Lease&& other) {
+    if (this != &other) {
+        if (pool && detector) {
+            pool->release(std::move(detector));
+        }
+        pool = other.pool;
+        detector = std::move(other.detector);
+    }
+    return *this;
+}
+
+DetectorPool::Lease::~Lease() {
+    if (pool && detector) {
+        pool->release(std::move(detector));
+    }
+}
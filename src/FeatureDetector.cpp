@@ -7,32 +7,79 @@
 
 #include "FeatureDetector.hpp"
 #include <algorithm>
+#include <fstream>
+#include <sstream>
 
-FeatureDetector::FeatureDetector(const std::string& cascade_path) {
-    if (!cascade.load(cascade_path)) {
-        throw std::runtime_error("Failed to load Haar cascade from: " + cascade_path);
+namespace {
+    constexpr double kScaleFactor = 1.1;
+    constexpr int kMinNeighbors = 3;
+}
+
+std::shared_ptr<CascadeModel> parseCascadeModel(const std::string& modelBuffer) {
+    auto model = std::make_shared<CascadeModel>();
+    model->storage = cv::FileStorage(modelBuffer, cv::FileStorage::READ | cv::FileStorage::MEMORY);
+    if (!model->storage.isOpened()) {
+        throw std::runtime_error("Failed to parse Haar cascade from memory buffer");
     }
+    model->source_bytes = modelBuffer.size();
+    return model;
 }
 
-std::vector<cv::Rect> FeatureDetector::detect(const cv::Mat& image) {
-    std::vector<cv::Rect> faces;
+bool isBiggerFace(const cv::Rect& a, const cv::Rect& b) {
+    if (a.area() != b.area()) {
+        return a.area() > b.area();
+    }
+    if (a.y != b.y) {
+        return a.y < b.y;
+    }
+    return a.x != b.x ? a.x < b.x : a.width < b.width;
+}
+
+void FeatureDetector::loadModel(const std::string& modelPath) {
+    std::ifstream file(modelPath, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Failed to load Haar cascade from: " + modelPath);
+    }
+    std::ostringstream content;
+    content << file.rdbuf();
+    loadModel(parseCascadeModel(content.str()));
+}
+
+void FeatureDetector::loadModelFromMemory(const std::string& modelBuffer) {
+    loadModel(parseCascadeModel(modelBuffer));
+}
+
+void FeatureDetector::loadModel(const std::shared_ptr<CascadeModel>& parsedModel) {
+    if (!parsedModel || !cascade.read(parsedModel->storage.getFirstTopLevelNode())) {
+        throw std::runtime_error("Failed to load Haar cascade from parsed model");
+    }
+}
+
+std::vector<DetectedFeature> FeatureDetector::detect(const cv::Mat& image) {
     cv::Mat gray;
 
     // Convert to grayscale if needed
     if (image.channels() == 3) {
         cv::cvtColor(image, gray, cv::COLOR_BGR2GRAY);
     } else {
-        gray = image.clone();
+        gray = image;
     }
-
-    // Detect faces
-    cascade.detectMultiScale(gray, faces, 1.1, 3, 0, cv::Size(30, 30));
+    std::vector<cv::Rect> faces = detectFaces(gray, getMinFaceSize());
 
     // Sort bounding boxes, biggest is first
-    std::sort(faces.begin(), faces.end(), [](const cv::Rect& a, const cv::Rect& b) {
-        return a.area() > b.area();
-    });
+    std::sort(faces.begin(), faces.end(), isBiggerFace);
 
-    return faces;
+    std::vector<DetectedFeature> detected;
+    detected.reserve(faces.size());
+    for (const cv::Rect& face : faces) {
+        detected.push_back({label, face});
+    }
+    return detected;
 }
 
+std::vector<cv::Rect> FeatureDetector::detectFaces(const cv::Mat& gray, const cv::Size& minSize,
+                                                   const cv::Size& maxSize) {
+    std::vector<cv::Rect> faces;
+    cascade.detectMultiScale(gray, faces, kScaleFactor, kMinNeighbors, 0, minSize, maxSize);
+    return faces;
+}
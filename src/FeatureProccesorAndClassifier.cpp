@@ -7,3 +7,140 @@
 //
 
 #include "FeatureProccesorAndClassifier.hpp"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace {
+    // Typical ratio of the largest face area to the frame area for each shot type.
+    // Classification picks the nearest centre in log space, which puts the decision
+    // boundaries at ~4.9 % (close-up / medium) and ~0.77 % (medium / wide).
+    constexpr double kCloseUpFaceRatio = 0.12;
+    constexpr double kMediumFaceRatio = 0.02;
+    constexpr double kWideFaceRatio = 0.003;
+    constexpr double kLogRatioSpread = 0.5; ///< Width of the per-class Gaussian in log10 units
+
+    // Pre-classification thresholds on GlobalFrameFeatures
+    constexpr double kBlackMaxLuma = 16.;
+    constexpr double kBlackMaxStddev = 10.;
+    constexpr double kCreditsMinDark = 0.85;
+    constexpr double kCreditsMinBright = 0.003;
+    constexpr double kCreditsMaxBright = 0.15;
+    constexpr double kCreditsMinEdges = 0.01;
+    constexpr double kCreditsMaxChroma = 0.1;
+    constexpr double kCreditsMinStrokes = 0.8;   ///< Share of bright runs as narrow as a letter stroke
+    constexpr double kCreditsMaxTextRows = 0.6;  ///< Text lines are separated by empty rows
+    constexpr double kMinEdgeDensity = 0.002;
+    constexpr double kMonochromeMaxChroma = 0.05;
+    constexpr double kMinFaceSide = 30.;        ///< Smallest face the detectors look for, in pixels
+    constexpr double kMinFaceSkinShare = 0.25;  ///< Part of such a face that is at least skin-toned
+}
+
+double ShotFeatureExtractor::returnTotalArea(const cv::Mat& frame) {
+    return (double)frame.cols * frame.rows;
+}
+
+double ShotFeatureExtractor::returnLaregstObjectArea(const std::vector<DetectedFeature>& features) {
+    double largest = 0.;
+    for (const DetectedFeature& feature : features) {
+        largest = std::max(largest, (double)feature.boundingBox.area());
+    }
+    return largest;
+}
+
+double ShotFeatureExtractor::returnTotalObjectArea(const std::vector<DetectedFeature>& features) {
+    double total = 0.;
+    for (const DetectedFeature& feature : features) {
+        total += feature.boundingBox.area();
+    }
+    return total;
+}
+
+ShotFeatures ShotFeatureExtractor::extract(const cv::Mat& frame, const std::vector<DetectedFeature>& features) {
+    ShotFeatures shot_features;
+    shot_features.object_count = (int)features.size();
+    shot_features.total_area = returnTotalArea(frame);
+    shot_features.largest_object_area = returnLaregstObjectArea(features);
+    shot_features.total_object_area = returnTotalObjectArea(features);
+
+    // Detections of several detectors may be concatenated, so order by size here
+    std::vector<size_t> order(features.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return features[a].boundingBox.area() > features[b].boundingBox.area();
+    });
+
+    shot_features.object_centers.reserve(features.size());
+    for (size_t index : order) {
+        const cv::Rect& box = features[index].boundingBox;
+        shot_features.object_centers.emplace_back(box.x + box.width * 0.5f, box.y + box.height * 0.5f);
+    }
+    return shot_features;
+}
+
+FrameContent ShotFeatureExtractor::prefilter(const GlobalFrameFeatures& global) const {
+    if (global.mean_luma < kBlackMaxLuma && global.luma_stddev < kBlackMaxStddev) {
+        return FrameContent::BLACK;
+    }
+    // A dark frame with a few bright spots may also be a dimly lit face, so credits need
+    // text structure (narrow strokes in separate lines) and not a single skin-toned pixel
+    if (global.dark_ratio > kCreditsMinDark && global.bright_ratio > kCreditsMinBright &&
+        global.bright_ratio < kCreditsMaxBright && global.edge_density > kCreditsMinEdges &&
+        global.chroma_ratio < kCreditsMaxChroma && global.skin_ratio == 0. &&
+        global.stroke_ratio >= kCreditsMinStrokes && global.text_row_ratio <= kCreditsMaxTextRows) {
+        return FrameContent::CREDITS;
+    }
+    if (global.edge_density < kMinEdgeDensity) {
+        return FrameContent::NO_FACE;
+    }
+    // Skin tone is meaningless for black-and-white footage
+    if (global.chroma_ratio >= kMonochromeMaxChroma && global.frame_area > 0.) {
+        const double min_skin_ratio = kMinFaceSkinShare * kMinFaceSide * kMinFaceSide / global.frame_area;
+        if (global.skin_ratio < min_skin_ratio) {
+            return FrameContent::NO_FACE;
+        }
+    }
+    return FrameContent::REGULAR;
+}
+
+ClassificationResult ShotClassifier::classify(const ShotFeatures& features) const {
+    ClassificationResult result;
+
+    if (features.content == FrameContent::BLACK || features.content == FrameContent::CREDITS) {
+        result.predictedType = features.content == FrameContent::BLACK ? ShotType::BLACK : ShotType::CREDITS;
+        result.probabilities[result.predictedType] = 1.;
+        return result;
+    }
+
+    // Without a face we cannot estimate the shot size
+    if (features.object_count == 0 || features.total_area <= 0. || features.largest_object_area <= 0.) {
+        result.predictedType = ShotType::UNKNOWN;
+        result.probabilities[ShotType::UNKNOWN] = 1.;
+        return result;
+    }
+
+    const double log_ratio = std::log10(features.largest_object_area / features.total_area);
+    const std::pair<ShotType, double> centres[] = {
+        {ShotType::CLOSE_UP, std::log10(kCloseUpFaceRatio)},
+        {ShotType::MEDIUM, std::log10(kMediumFaceRatio)},
+        {ShotType::WIDE, std::log10(kWideFaceRatio)},
+    };
+
+    double sum = 0.;
+    for (const auto& [type, centre] : centres) {
+        const double distance = (log_ratio - centre) / kLogRatioSpread;
+        const double score = std::exp(-0.5 * distance * distance);
+        result.probabilities[type] = score;
+        sum += score;
+    }
+
+    double best = -1.;
+    for (auto& [type, probability] : result.probabilities) {
+        probability = sum > 0. ? probability / sum : 1. / 3.;
+        if (probability > best) {
+            best = probability;
+            result.predictedType = type;
+        }
+    }
+    return result;
+}
@@ -6,4 +6,177 @@
 //
 
 #include "FileLoader.hpp"
+#include <cmath>
 
+ImageLoader::ImageLoader(const std::string& path) : InputSource(path), image(cv::imread(path, cv::IMREAD_COLOR)) {
+    if (image.empty()) {
+        throw std::runtime_error("Failed to load image from: " + path);
+    }
+}
+
+ImageLoader::ImageLoader(const std::string& name, const cv::Mat& frame) : InputSource(name), image(frame) {
+    if (image.empty()) {
+        throw std::runtime_error("Empty image: " + name);
+    }
+}
+
+bool ImageLoader::hasNextFrame() const {
+    return !frame_returned;
+}
+
+cv::Mat& ImageLoader::nextFrame() {
+    frame_returned = true;
+    return image;
+}
+
+double ImageLoader::getCurrentTimestamp() const {
+    return 0.;
+}
+
+VideoLoader::VideoLoader(const std::string& path, double startMs, double endMs) : InputSource(path), end_ms(endMs) {
+    if (!capture.open(path)) {
+        throw std::runtime_error("Failed to open video: " + path);
+    }
+    if (startMs > 0.) {
+        capture.set(cv::CAP_PROP_POS_MSEC, startMs);
+    }
+    readAhead();
+    // Seeking is only accurate to the nearest key frame, skip frames before the range
+    while (has_pending && pending_timestamp < startMs) {
+        readAhead();
+    }
+}
+
+void VideoLoader::readAhead() {
+    // Drop our reference first so read() decodes into a new buffer instead of
+    // overwriting a frame the caller may still hold
+    pending_frame.release();
+    has_pending = capture.read(pending_frame) && !pending_frame.empty();
+    pending_timestamp = capture.get(cv::CAP_PROP_POS_MSEC);
+    if (has_pending && end_ms >= 0. && pending_timestamp > end_ms) {
+        has_pending = false;
+    }
+}
+
+bool VideoLoader::hasNextFrame() const {
+    return has_pending;
+}
+
+cv::Mat& VideoLoader::nextFrame() {
+    std::swap(current_frame, pending_frame);
+    current_timestamp = pending_timestamp;
+    readAhead();
+    return current_frame;
+}
+
+double VideoLoader::getCurrentTimestamp() const {
+    return current_timestamp;
+}
+
+void Preprocessing::LoadFrame(cv::Mat& frame) {
+    image = frame;
+}
+
+cv::Mat& Preprocessing::GetProcessedImage() {
+    return image;
+}
+
+GlobalFrameFeatures Preprocessing::ComputeGlobalFeatures(int maxWidth) const {
+    GlobalFrameFeatures global;
+    if (image.empty()) {
+        return global;
+    }
+    global.frame_area = (double)image.cols * image.rows;
+
+    cv::Mat small;
+    if (image.cols > maxWidth && maxWidth > 0) {
+        const double scale = (double)maxWidth / image.cols;
+        cv::resize(image, small, cv::Size(), scale, scale, cv::INTER_AREA);
+    } else {
+        small = image;
+    }
+    cv::Mat bgr;
+    if (small.channels() == 1) {
+        cv::cvtColor(small, bgr, cv::COLOR_GRAY2BGR);
+    } else if (small.channels() == 4) {
+        cv::cvtColor(small, bgr, cv::COLOR_BGRA2BGR);
+    } else {
+        bgr = small;
+    }
+
+    constexpr double kDarkLuma = 40;
+    constexpr double kBrightLuma = 180;
+    constexpr double kEdgeStep = 48;     // |dx| + |dy| of the luminance counted as an edge
+    constexpr double kChromaOffset = 10; // |Cr - 128| + |Cb - 128| counted as coloured
+    constexpr int kMaxStrokeWidth = 8;   // longest horizontal bright run counted as a letter stroke
+
+    // Whole-image OpenCV operations, each one a vectorized pass over the pixels
+    cv::Mat ycrcb;
+    cv::cvtColor(bgr, ycrcb, cv::COLOR_BGR2YCrCb);
+    std::vector<cv::Mat> planes;
+    cv::split(ycrcb, planes);
+    const cv::Mat& luma = planes[0];
+
+    cv::Scalar mean, stddev;
+    cv::meanStdDev(luma, mean, stddev);
+
+    cv::Mat mask;
+    cv::compare(luma, kDarkLuma, mask, cv::CMP_LT);
+    const int dark = cv::countNonZero(mask);
+    cv::Mat bright_mask;
+    cv::compare(luma, kBrightLuma, bright_mask, cv::CMP_GT);
+    const int bright = cv::countNonZero(bright_mask);
+
+    cv::inRange(ycrcb, cv::Scalar(0, 133, 77), cv::Scalar(255, 173, 127), mask);
+    const int skin = cv::countNonZero(mask);
+
+    cv::Mat cr_offset, cb_offset;
+    cv::absdiff(planes[1], cv::Scalar(128), cr_offset);
+    cv::absdiff(planes[2], cv::Scalar(128), cb_offset);
+    cv::add(cr_offset, cb_offset, cr_offset); // saturates at 255, far above the threshold
+    cv::compare(cr_offset, kChromaOffset, mask, cv::CMP_GT);
+    const int chroma = cv::countNonZero(mask);
+
+    // Horizontal and vertical luminance steps from views shifted by one pixel
+    int edges = 0;
+    if (luma.cols > 1 && luma.rows > 1) {
+        const cv::Rect inner(1, 1, luma.cols - 1, luma.rows - 1);
+        cv::Mat step_x, step_y;
+        cv::absdiff(luma(inner), luma(inner - cv::Point(1, 0)), step_x);
+        cv::absdiff(luma(inner), luma(inner - cv::Point(0, 1)), step_y);
+        cv::add(step_x, step_y, step_x);
+        cv::compare(step_x, kEdgeStep, mask, cv::CMP_GT);
+        edges = cv::countNonZero(mask);
+    }
+
+    // Horizontal runs of bright pixels; a sequential scan over the mask rows
+    int runs = 0, short_runs = 0, text_rows = 0;
+    for (int y = 0; y < bright_mask.rows; y++) {
+        const uchar* row = bright_mask.ptr<uchar>(y);
+        int run = 0;
+        bool row_bright = false;
+        for (int x = 0; x <= bright_mask.cols; x++) {
+            if (x < bright_mask.cols && row[x]) {
+                run++;
+                row_bright = true;
+            } else if (run > 0) {
+                runs++;
+                short_runs += run <= kMaxStrokeWidth;
+                run = 0;
+            }
+        }
+        text_rows += row_bright;
+    }
+
+    const double pixels = (double)bgr.cols * bgr.rows;
+    global.mean_luma = mean[0];
+    global.luma_stddev = stddev[0];
+    global.dark_ratio = dark / pixels;
+    global.bright_ratio = bright / pixels;
+    global.edge_density = edges / pixels;
+    global.skin_ratio = skin / pixels;
+    global.chroma_ratio = chroma / pixels;
+    global.stroke_ratio = runs > 0 ? (double)short_runs / runs : 0.;
+    global.text_row_ratio = bgr.rows > 0 ? (double)text_rows / bgr.rows : 0.;
+    return global;
+}
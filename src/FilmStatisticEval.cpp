@@ -6,3 +6,214 @@
 //
 
 #include "FilmStatisticEval.hpp"
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <unistd.h>
+
+/// Spill file holding the oldest part of a timeline, removed with its last owner.
+struct TimelineSpill {
+    std::string path;    ///< Spill file path
+    size_t entries = 0;  ///< Number of entries in the file
+
+    ~TimelineSpill() { std::remove(path.c_str()); }
+};
+
+namespace {
+    constexpr size_t kTimelineEntryBytes = sizeof(std::pair<double, ShotType>);
+}
+
+FilmStatistics::FilmStatistics(const FilmStatistics& other)
+    : step(other.step), shot_counts(other.shot_counts), timeline(other.timeline), totalFrames(other.totalFrames),
+      memory_budget(other.memory_budget), spill_directory(other.spill_directory), spill(other.spill)
+{
+    if (memory_budget) {
+        memory_budget->add(MemoryComponent::STATISTICS, (long long)(timeline.size() * kTimelineEntryBytes));
+    }
+}
+
+FilmStatistics::FilmStatistics(FilmStatistics&& other) noexcept
+    : step(other.step), shot_counts(std::move(other.shot_counts)), timeline(std::move(other.timeline)),
+      totalFrames(other.totalFrames), memory_budget(other.memory_budget),
+      spill_directory(std::move(other.spill_directory)), spill(std::move(other.spill))
+{
+    other.timeline.clear(); // the accounted entries moved here
+}
+
+FilmStatistics& FilmStatistics::operator=(const FilmStatistics& other)
+{
+    if (this != &other) {
+        *this = FilmStatistics(other);
+    }
+    return *this;
+}
+
+FilmStatistics& FilmStatistics::operator=(FilmStatistics&& other) noexcept
+{
+    if (this != &other) {
+        if (memory_budget) {
+            memory_budget->add(MemoryComponent::STATISTICS, -(long long)(timeline.size() * kTimelineEntryBytes));
+        }
+        step = other.step;
+        shot_counts = std::move(other.shot_counts);
+        timeline = std::move(other.timeline);
+        totalFrames = other.totalFrames;
+        memory_budget = other.memory_budget;
+        spill_directory = std::move(other.spill_directory);
+        spill = std::move(other.spill);
+        other.timeline.clear();
+    }
+    return *this;
+}
+
+FilmStatistics::~FilmStatistics()
+{
+    if (memory_budget) {
+        memory_budget->add(MemoryComponent::STATISTICS, -(long long)(timeline.size() * kTimelineEntryBytes));
+    }
+}
+
+void FilmStatistics::addFrameResult(double timestampMs, const ClassificationResult& result)
+{
+    // Only every step-th frame contributes to the statistics
+    if (totalFrames++ % step != 0) {
+        return;
+    }
+    shot_counts[result.predictedType]++;
+    timeline.emplace_back(timestampMs, result.predictedType);
+
+    if (memory_budget) {
+        memory_budget->add(MemoryComponent::STATISTICS, kTimelineEntryBytes);
+        if (timeline.size() * kTimelineEntryBytes > memory_budget->getLimit(MemoryComponent::STATISTICS)) {
+            spillTimeline();
+        }
+    }
+}
+
+void FilmStatistics::setMemoryBudget(MemoryBudget* budget, const std::string& spillDirectory)
+{
+    if (memory_budget) {
+        memory_budget->add(MemoryComponent::STATISTICS, -(long long)(timeline.size() * kTimelineEntryBytes));
+    }
+    memory_budget = budget;
+    spill_directory = spillDirectory;
+    if (memory_budget) {
+        memory_budget->add(MemoryComponent::STATISTICS, (long long)(timeline.size() * kTimelineEntryBytes));
+    }
+}
+
+void FilmStatistics::spillTimeline()
+{
+    // Copy-on-write: a file shared with a copy of this object is duplicated before appending
+    if (!spill || spill.use_count() > 1) {
+        namespace fs = std::filesystem;
+        const fs::path directory = spill_directory.empty() ? fs::temp_directory_path() : fs::path(spill_directory);
+        auto own = std::make_shared<TimelineSpill>();
+        own->path = (directory / ("film_timeline_" + std::to_string(getpid()) + "_" +
+                                  std::to_string((uintptr_t)own.get()) + ".bin")).string();
+        if (spill) {
+            fs::copy_file(spill->path, own->path);
+            own->entries = spill->entries;
+        }
+        spill = std::move(own);
+    }
+
+    std::ofstream file(spill->path, std::ios::binary | std::ios::app);
+    for (const auto& [timestamp, type] : timeline) {
+        const int32_t code = (int32_t)type;
+        file.write(reinterpret_cast<const char*>(&timestamp), sizeof(timestamp));
+        file.write(reinterpret_cast<const char*>(&code), sizeof(code));
+    }
+    if (!file) {
+        throw std::runtime_error("Failed to spill timeline to: " + spill->path);
+    }
+    spill->entries += timeline.size();
+
+    // The capacity is kept, it is bounded by the budget and avoids reallocating on every spill
+    memory_budget->add(MemoryComponent::STATISTICS, -(long long)(timeline.size() * kTimelineEntryBytes));
+    timeline.clear();
+}
+
+void FilmStatistics::visitTimeline(const std::function<void(double, ShotType)>& visitor) const
+{
+    if (spill) {
+        std::ifstream file(spill->path, std::ios::binary);
+        double timestamp = 0.;
+        int32_t code = 0;
+        for (size_t i = 0; i < spill->entries &&
+                           file.read(reinterpret_cast<char*>(&timestamp), sizeof(timestamp)) &&
+                           file.read(reinterpret_cast<char*>(&code), sizeof(code)); i++) {
+            visitor(timestamp, (ShotType)code);
+        }
+    }
+    for (const auto& [timestamp, type] : timeline) {
+        visitor(timestamp, type);
+    }
+}
+
+std::vector<std::pair<double, ShotType>> FilmStatistics::loadTimeline() const
+{
+    std::vector<std::pair<double, ShotType>> full;
+    full.reserve((spill ? spill->entries : 0) + timeline.size());
+    visitTimeline([&](double timestamp, ShotType type) { full.emplace_back(timestamp, type); });
+    return full;
+}
+
+void FilmStatistics::setFrameStep(size_t stride)
+{
+    step = stride > 0 ? stride : 1;
+}
+
+int FilmStatistics::getAnalyzedFrames() const
+{
+    int analyzed = 0;
+    for (const auto& [type, count] : shot_counts) {
+        analyzed += count;
+    }
+    return analyzed;
+}
+
+ShotType FilmStatistics::getDominantShotType() const
+{
+    ShotType dominant = ShotType::UNKNOWN;
+    int best = 0;
+    for (const auto& [type, count] : shot_counts) {
+        if (count > best) {
+            best = count;
+            dominant = type;
+        }
+    }
+    return dominant;
+}
+
+void FilmStatistics::exportToCSV(const std::string& path) const
+{
+    std::ofstream file(path);
+    if (!file) {
+        throw std::runtime_error("Failed to open CSV file for writing: " + path);
+    }
+
+    // Streamed, so a spilled timeline is never loaded into memory as a whole
+    file << "timestamp_ms,shot_type\n";
+    visitTimeline([&](double timestamp, ShotType type) {
+        file << timestamp << ',' << shotTypeToString(type) << '\n';
+    });
+
+    file << "\nshot_type,count\n";
+    for (const auto& [type, count] : shot_counts) {
+        file << shotTypeToString(type) << ',' << count << '\n';
+    }
+}
+
+void FilmStatistics::printSummary() const
+{
+    const int analyzed = getAnalyzedFrames();
+    std::cout << "Frames processed: " << totalFrames << " (analyzed: " << analyzed << ", step: " << step << ")\n";
+    for (const auto& [type, count] : shot_counts) {
+        const double percent = analyzed > 0 ? 100. * count / analyzed : 0.;
+        std::cout << "  " << std::left << std::setw(10) << shotTypeToString(type)
+                  << std::right << std::setw(8) << count << "  "
+                  << std::fixed << std::setprecision(1) << percent << " %\n";
+    }
+    std::cout << std::defaultfloat;
+}
@@ -0,0 +1,134 @@
+//
+//  MemoryBudget.cpp
+//  Film_type_classifier
+//
+
+#include "MemoryBudget.hpp"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <sys/resource.h>
+#ifdef __APPLE__
+#include <mach/mach.h>
+#endif
+
+std::string memoryComponentToString(MemoryComponent component)
+{
+    switch (component) {
+        case MemoryComponent::LOADER_QUEUE:    return "LOADER_QUEUE";
+        case MemoryComponent::FRAME_POOL:      return "FRAME_POOL";
+        case MemoryComponent::DETECTION_CACHE: return "DETECTION_CACHE";
+        case MemoryComponent::STATISTICS:      return "STATISTICS";
+        case MemoryComponent::COUNT:           break;
+    }
+    return "UNKNOWN";
+}
+
+MemoryBudget::MemoryBudget(size_t totalBytes) : total_bytes(totalBytes), shares{0.15, 0.40, 0.35, 0.10}
+{
+}
+
+void MemoryBudget::setShare(MemoryComponent component, double share)
+{
+    shares[(size_t)component] = std::clamp(share, 0., 1.);
+}
+
+size_t MemoryBudget::getLimit(MemoryComponent component) const
+{
+    return (size_t)(total_bytes * shares[(size_t)component]);
+}
+
+void MemoryBudget::updatePeak(size_t index, size_t value)
+{
+    size_t previous = peak[index].load();
+    while (value > previous && !peak[index].compare_exchange_weak(previous, value)) {
+    }
+}
+
+void MemoryBudget::add(MemoryComponent component, long long bytes)
+{
+    const size_t index = (size_t)component;
+    if (bytes >= 0) {
+        updatePeak(index, current[index].fetch_add((size_t)bytes) + (size_t)bytes);
+        return;
+    }
+    // Never underflow, a component may release slightly more than it estimated on acquire
+    size_t previous = current[index].load();
+    size_t next;
+    do {
+        next = previous > (size_t)(-bytes) ? previous - (size_t)(-bytes) : 0;
+    } while (!current[index].compare_exchange_weak(previous, next));
+}
+
+size_t MemoryBudget::getCurrent(MemoryComponent component) const
+{
+    return current[(size_t)component].load();
+}
+
+size_t MemoryBudget::getPeak(MemoryComponent component) const
+{
+    return peak[(size_t)component].load();
+}
+
+bool MemoryBudget::fits(MemoryComponent component, size_t bytes) const
+{
+    return getCurrent(component) + bytes <= getLimit(component);
+}
+
+void MemoryBudget::printReport() const
+{
+    auto megabytes = [](size_t bytes) { return bytes / (1024. * 1024.); };
+
+    std::cout << std::fixed << std::setprecision(1)
+              << "Memory budget: " << megabytes(total_bytes) << " MB\n";
+    for (size_t i = 0; i < kMemoryComponentCount; i++) {
+        const MemoryComponent component = (MemoryComponent)i;
+        std::cout << "  " << std::left << std::setw(16) << memoryComponentToString(component) << std::right
+                  << " current " << std::setw(8) << megabytes(getCurrent(component)) << " MB"
+                  << "  peak " << std::setw(8) << megabytes(getPeak(component)) << " MB"
+                  << "  limit " << std::setw(8) << megabytes(getLimit(component)) << " MB\n";
+    }
+    // The two values come from different sources, so the peak is clamped to stay >= current
+    const size_t rss = currentProcessRss();
+    std::cout << "  process RSS      current " << std::setw(8) << megabytes(rss) << " MB"
+              << "  peak " << std::setw(8) << megabytes(std::max(rss, peakProcessRss())) << " MB\n";
+    std::cout << std::defaultfloat;
+}
+
+size_t currentProcessRss()
+{
+#ifdef __APPLE__
+    mach_task_basic_info info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &count) == KERN_SUCCESS) {
+        return (size_t)info.resident_size;
+    }
+    return 0;
+#else
+    std::ifstream status("/proc/self/status");
+    std::string key;
+    while (status >> key) {
+        if (key == "VmRSS:") {
+            size_t kilobytes = 0;
+            status >> kilobytes;
+            return kilobytes * 1024;
+        }
+        status.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    }
+    return 0;
+#endif
+}
+
+size_t peakProcessRss()
+{
+    rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+#ifdef __APPLE__
+    return (size_t)usage.ru_maxrss;         // bytes on macOS
+#else
+    return (size_t)usage.ru_maxrss * 1024;  // kilobytes on Linux
+#endif
+}
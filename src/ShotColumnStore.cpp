@@ -0,0 +1,345 @@
+//
+//  ShotColumnStore.cpp
+//  Film_type_classifier
+//
+
+#include "ShotColumnStore.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    const char kMagic[8] = {'S', 'H', 'O', 'T', 'C', 'O', 'L', '1'};
+
+    enum ValueType : uint8_t { kFloat64 = 0, kInt32 = 1, kDictionary = 2 };
+
+    struct ColumnSpec {
+        const char* name;
+        ValueType type;
+    };
+
+    // Column order of every chunk
+    const ColumnSpec kColumns[] = {
+        {"start_ms", kFloat64},
+        {"end_ms", kFloat64},
+        {"type", kDictionary},
+        {"confidence", kFloat64},
+        {"face_count", kInt32},
+        {"largest_face_ratio", kFloat64},
+        {"frame_count", kInt32},
+    };
+    constexpr size_t kColumnCount = sizeof(kColumns) / sizeof(kColumns[0]);
+
+    size_t valueWidth(uint8_t type) {
+        return type == kFloat64 ? sizeof(double) : type == kInt32 ? sizeof(int32_t) : sizeof(uint8_t);
+    }
+
+    template <typename T>
+    void writeValue(std::ofstream& out, const T& value) {
+        out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    void writeName(std::ofstream& out, const std::string& name) {
+        writeValue(out, (uint8_t)name.size());
+        out.write(name.data(), name.size());
+    }
+
+    template <typename T>
+    T readValue(std::ifstream& in) {
+        T value{};
+        in.read(reinterpret_cast<char*>(&value), sizeof(T));
+        return value;
+    }
+
+    std::string readName(std::ifstream& in) {
+        std::string name(readValue<uint8_t>(in), '\0');
+        in.read(name.data(), name.size());
+        return name;
+    }
+
+    // Writes one column of all rows of a chunk
+    template <typename T, typename Getter>
+    void writeColumn(std::ofstream& out, const std::vector<ShotRecord>& rows, Getter get) {
+        std::vector<T> values;
+        values.reserve(rows.size());
+        for (const ShotRecord& row : rows) {
+            values.push_back((T)get(row));
+        }
+        out.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+    }
+}
+
+ShotColumnWriter::ShotColumnWriter(const std::string& path, size_t chunkRows)
+    : file(path, std::ios::binary | std::ios::trunc), chunk_rows(std::max<size_t>(chunkRows, 1))
+{
+    if (!file) {
+        throw std::runtime_error("Failed to create shot column file: " + path);
+    }
+    file.write(kMagic, sizeof(kMagic));
+    chunk.reserve(chunk_rows);
+}
+
+ShotColumnWriter::~ShotColumnWriter()
+{
+    if (!finished) {
+        try {
+            finish();
+        } catch (const std::exception& e) {
+            std::cerr << "ShotColumnWriter: " << e.what() << std::endl;
+        }
+    }
+}
+
+uint8_t ShotColumnWriter::encode(ShotType type)
+{
+    auto it = std::find(dictionary.begin(), dictionary.end(), type);
+    if (it != dictionary.end()) {
+        return (uint8_t)(it - dictionary.begin());
+    }
+    dictionary.push_back(type);
+    return (uint8_t)(dictionary.size() - 1);
+}
+
+void ShotColumnWriter::addFrame(double timestampMs, const ShotFeatures& features, const ClassificationResult& result)
+{
+    // Shots and the chunk index are only valid for frames in time order
+    if (timestampMs < last_ms) {
+        throw std::runtime_error("Shot column frames out of order: " + std::to_string(timestampMs) +
+                                 " ms after " + std::to_string(last_ms) + " ms");
+    }
+    last_ms = timestampMs;
+    if (current.frame_count > 0 && result.predictedType != current.type) {
+        closeShot();
+    }
+
+    auto probability = result.probabilities.find(result.predictedType);
+    const double ratio = features.total_area > 0. ? features.largest_object_area / features.total_area : 0.;
+
+    if (current.frame_count == 0) {
+        current.start_ms = timestampMs;
+        current.type = result.predictedType;
+    }
+    current.end_ms = timestampMs;
+    current.face_count = std::max(current.face_count, features.object_count);
+    current.largest_face_ratio = std::max(current.largest_face_ratio, ratio);
+    current.frame_count++;
+    confidence_sum += probability != result.probabilities.end() ? probability->second : 0.;
+}
+
+void ShotColumnWriter::closeShot()
+{
+    current.confidence = confidence_sum / current.frame_count;
+    chunk.push_back(current);
+    current = ShotRecord();
+    confidence_sum = 0.;
+
+    if (chunk.size() >= chunk_rows) {
+        flushChunk();
+    }
+}
+
+void ShotColumnWriter::flushChunk()
+{
+    if (chunk.empty()) {
+        return;
+    }
+
+    ShotColumnChunk entry;
+    entry.rows = (uint32_t)chunk.size();
+    entry.first_start_ms = chunk.front().start_ms;
+    entry.last_start_ms = chunk.back().start_ms;
+
+    auto column_start = [&]() { entry.offsets.push_back((uint64_t)file.tellp()); };
+    column_start();
+    writeColumn<double>(file, chunk, [](const ShotRecord& r) { return r.start_ms; });
+    column_start();
+    writeColumn<double>(file, chunk, [](const ShotRecord& r) { return r.end_ms; });
+    column_start();
+    writeColumn<uint8_t>(file, chunk, [this](const ShotRecord& r) { return encode(r.type); });
+    column_start();
+    writeColumn<double>(file, chunk, [](const ShotRecord& r) { return r.confidence; });
+    column_start();
+    writeColumn<int32_t>(file, chunk, [](const ShotRecord& r) { return r.face_count; });
+    column_start();
+    writeColumn<double>(file, chunk, [](const ShotRecord& r) { return r.largest_face_ratio; });
+    column_start();
+    writeColumn<int32_t>(file, chunk, [](const ShotRecord& r) { return r.frame_count; });
+
+    chunk_index.push_back(std::move(entry));
+    chunk.clear();
+
+    if (!file) {
+        throw std::runtime_error("Failed to write shot column chunk");
+    }
+}
+
+void ShotColumnWriter::finish()
+{
+    if (finished) {
+        return;
+    }
+    finished = true;
+
+    if (current.frame_count > 0) {
+        closeShot();
+    }
+    flushChunk();
+
+    const uint64_t footer_offset = (uint64_t)file.tellp();
+    writeValue(file, (uint32_t)kColumnCount);
+    for (const ColumnSpec& column : kColumns) {
+        writeName(file, column.name);
+        writeValue(file, (uint8_t)column.type);
+    }
+    writeValue(file, (uint32_t)dictionary.size());
+    for (ShotType type : dictionary) {
+        writeName(file, shotTypeToString(type));
+    }
+    writeValue(file, (uint32_t)chunk_index.size());
+    for (const ShotColumnChunk& entry : chunk_index) {
+        writeValue(file, entry.rows);
+        writeValue(file, entry.first_start_ms);
+        writeValue(file, entry.last_start_ms);
+        for (uint64_t offset : entry.offsets) {
+            writeValue(file, offset);
+        }
+    }
+    writeValue(file, footer_offset);
+    file.write(kMagic, sizeof(kMagic));
+    file.close();
+
+    if (file.fail()) {
+        throw std::runtime_error("Failed to write shot column footer");
+    }
+}
+
+ShotColumnReader::ShotColumnReader(const std::string& path) : file(path, std::ios::binary)
+{
+    char magic[sizeof(kMagic)] = {};
+    file.read(magic, sizeof(magic));
+    if (!file || std::memcmp(magic, kMagic, sizeof(kMagic)) != 0) {
+        throw std::runtime_error("Not a shot column file: " + path);
+    }
+
+    file.seekg(-(std::streamoff)(sizeof(uint64_t) + sizeof(kMagic)), std::ios::end);
+    const uint64_t footer_offset = readValue<uint64_t>(file);
+    file.read(magic, sizeof(magic));
+    if (!file || std::memcmp(magic, kMagic, sizeof(kMagic)) != 0) {
+        throw std::runtime_error("Truncated shot column file: " + path);
+    }
+
+    file.seekg((std::streamoff)footer_offset);
+    const uint32_t column_count = readValue<uint32_t>(file);
+    for (uint32_t i = 0; i < column_count; i++) {
+        column_names.push_back(readName(file));
+        column_types.push_back(readValue<uint8_t>(file));
+    }
+    const uint32_t dictionary_size = readValue<uint32_t>(file);
+    for (uint32_t i = 0; i < dictionary_size; i++) {
+        dictionary.push_back(shotTypeFromString(readName(file)));
+    }
+    const uint32_t chunk_count = readValue<uint32_t>(file);
+    for (uint32_t i = 0; i < chunk_count; i++) {
+        ShotColumnChunk entry;
+        entry.rows = readValue<uint32_t>(file);
+        entry.first_start_ms = readValue<double>(file);
+        entry.last_start_ms = readValue<double>(file);
+        for (uint32_t c = 0; c < column_count; c++) {
+            entry.offsets.push_back(readValue<uint64_t>(file));
+        }
+        chunks.push_back(std::move(entry));
+    }
+
+    if (!file) {
+        throw std::runtime_error("Corrupted shot column footer: " + path);
+    }
+}
+
+size_t ShotColumnReader::getRowCount() const
+{
+    size_t rows = 0;
+    for (const ShotColumnChunk& entry : chunks) {
+        rows += entry.rows;
+    }
+    return rows;
+}
+
+size_t ShotColumnReader::columnIndex(const std::string& name, uint8_t valueType) const
+{
+    for (size_t i = 0; i < column_names.size(); i++) {
+        if (column_names[i] == name) {
+            if (column_types[i] != valueType) {
+                throw std::runtime_error("Column " + name + " has a different value type");
+            }
+            return i;
+        }
+    }
+    throw std::runtime_error("No such column: " + name);
+}
+
+std::vector<char> ShotColumnReader::readColumn(const std::string& name, uint8_t valueType,
+                                               double startMs, double endMs) const
+{
+    const size_t column = columnIndex(name, valueType);
+    const size_t start_column = columnIndex("start_ms", kFloat64);
+    const size_t width = valueWidth(valueType);
+    std::vector<char> bytes;
+    std::vector<double> starts;
+
+    for (const ShotColumnChunk& entry : chunks) {
+        // Chunk index by timestamp: skip chunks entirely outside the range
+        if (entry.last_start_ms < startMs || entry.first_start_ms > endMs) {
+            continue;
+        }
+
+        // Rows are in start_ms order, so the rows of a chunk cut by the range are found by bisection
+        size_t first = 0, last = entry.rows;
+        if (entry.first_start_ms < startMs || entry.last_start_ms > endMs) {
+            starts.resize(entry.rows);
+            file.seekg((std::streamoff)entry.offsets[start_column]);
+            file.read(reinterpret_cast<char*>(starts.data()), entry.rows * sizeof(double));
+            first = std::lower_bound(starts.begin(), starts.end(), startMs) - starts.begin();
+            last = std::upper_bound(starts.begin(), starts.end(), endMs) - starts.begin();
+        }
+        if (last <= first) {
+            continue;
+        }
+
+        const size_t size = (last - first) * width;
+        bytes.resize(bytes.size() + size);
+        file.seekg((std::streamoff)(entry.offsets[column] + first * width));
+        file.read(bytes.data() + bytes.size() - size, size);
+    }
+
+    if (!file) {
+        throw std::runtime_error("Failed to read column " + name);
+    }
+    return bytes;
+}
+
+std::vector<double> ShotColumnReader::readDoubleColumn(const std::string& name, double startMs, double endMs) const
+{
+    std::vector<char> bytes = readColumn(name, kFloat64, startMs, endMs);
+    std::vector<double> values(bytes.size() / sizeof(double));
+    std::memcpy(values.data(), bytes.data(), bytes.size());
+    return values;
+}
+
+std::vector<int> ShotColumnReader::readIntColumn(const std::string& name, double startMs, double endMs) const
+{
+    std::vector<char> bytes = readColumn(name, kInt32, startMs, endMs);
+    std::vector<int32_t> raw(bytes.size() / sizeof(int32_t));
+    std::memcpy(raw.data(), bytes.data(), bytes.size());
+    return std::vector<int>(raw.begin(), raw.end());
+}
+
+std::vector<ShotType> ShotColumnReader::readShotTypes(double startMs, double endMs) const
+{
+    std::vector<char> codes = readColumn("type", kDictionary, startMs, endMs);
+    std::vector<ShotType> types;
+    types.reserve(codes.size());
+    for (char code : codes) {
+        const size_t index = (uint8_t)code;
+        types.push_back(index < dictionary.size() ? dictionary[index] : ShotType::UNKNOWN);
+    }
+    return types;
+}
@@ -0,0 +1,177 @@
+//
+//  ShotPipeline.cpp
+//  Film_type_classifier
+//
+
+#include "ShotPipeline.hpp"
+#include <algorithm>
+
+namespace {
+    constexpr double kSameFaceOverlap = 0.3; ///< IoU above which a profile face duplicates a frontal one
+
+    double intersectionOverUnion(const cv::Rect& a, const cv::Rect& b) {
+        const double intersection = (a & b).area();
+        const double union_area = a.area() + b.area() - intersection;
+        return union_area > 0. ? intersection / union_area : 0.;
+    }
+}
+
+void ShotPipeline::setMemoryBudget(MemoryBudget* budget)
+{
+    memory_budget = budget;
+    frontal_pool.setMemoryBudget(budget);
+    profile_pool.setMemoryBudget(budget);
+}
+
+void ShotPipeline::warmUp(size_t count)
+{
+    frontal_pool.warmUp(count);
+    profile_pool.warmUp(count);
+}
+
+std::vector<DetectedFeature> ShotPipeline::detect(const cv::Mat& frame)
+{
+    return detectFaces(frame, tile_max_face_size > 0);
+}
+
+std::vector<DetectedFeature> ShotPipeline::detectFaces(const cv::Mat& frame, bool tiled)
+{
+    // Convert once, both detectors accept a grayscale image as is
+    cv::Mat gray;
+    if (frame.channels() == 3) {
+        cv::cvtColor(frame, gray, cv::COLOR_BGR2GRAY);
+    } else {
+        gray = frame;
+    }
+
+    std::vector<DetectedFeature> detected;
+    std::vector<DetectedFeature> profiles;
+    if (tiled) {
+        detected = frontal_pool.detectTiled(gray, tile_max_face_size);
+        profiles = profile_pool.detectTiled(gray, tile_max_face_size);
+    } else {
+        {
+            DetectorPool::Lease frontal_detector = frontal_pool.checkout();
+            detected = frontal_detector->detect(gray);
+        }
+        DetectorPool::Lease profile_detector = profile_pool.checkout();
+        profiles = profile_detector->detect(gray);
+    }
+
+    const size_t frontal_count = detected.size();
+    for (const DetectedFeature& profile : profiles) {
+        bool duplicate = false;
+        for (size_t i = 0; i < frontal_count && !duplicate; i++) {
+            duplicate = intersectionOverUnion(profile.boundingBox, detected[i].boundingBox) > kSameFaceOverlap;
+        }
+        if (!duplicate) {
+            detected.push_back(profile);
+        }
+    }
+
+    std::sort(detected.begin(), detected.end(), [](const DetectedFeature& a, const DetectedFeature& b) {
+        return isBiggerFace(a.boundingBox, b.boundingBox);
+    });
+    return detected;
+}
+
+ClassificationResult ShotPipeline::classifyFrame(const cv::Mat& frame, ShotFeatures& features, bool tiled)
+{
+    if (prefilter_enabled) {
+        const Preprocessing preprocess(frame);
+        const FrameContent content = extractor.prefilter(preprocess.ComputeGlobalFeatures());
+        if (content != FrameContent::REGULAR) {
+            features = extractor.extract(frame, {});
+            features.content = content;
+            return classifier.classify(features);
+        }
+    }
+    features = extractor.extract(frame, detectFaces(frame, tiled));
+    return classifier.classify(features);
+}
+
+ClassificationResult ShotPipeline::processFrame(const cv::Mat& frame, ShotFeatures& features)
+{
+    return classifyFrame(frame, features, tile_max_face_size > 0);
+}
+
+std::vector<ClassificationResult> ShotPipeline::processBatch(const std::vector<cv::Mat>& frames,
+                                                             std::vector<ShotFeatures>* features)
+{
+    std::vector<ClassificationResult> results(frames.size());
+    std::vector<ShotFeatures> batch_features(frames.size());
+
+    cv::parallel_for_(cv::Range(0, (int)frames.size()), [&](const cv::Range& range) {
+        for (int i = range.start; i < range.end; i++) {
+            results[i] = classifyFrame(frames[i], batch_features[i], false);
+        }
+    });
+
+    if (features) {
+        *features = std::move(batch_features);
+    }
+    return results;
+}
+
+void ShotPipeline::processSource(InputSource& source, FilmStatistics& stats, ShotColumnWriter* shotWriter)
+{
+    std::vector<cv::Mat> frames;
+    std::vector<double> timestamps;
+    std::vector<ShotFeatures> features;
+    frames.reserve(batch_size);
+    timestamps.reserve(batch_size);
+
+    while (source.hasNextFrame()) {
+        frames.clear();
+        timestamps.clear();
+        size_t held_bytes = 0;
+        while (frames.size() < batch_size && source.hasNextFrame()) {
+            frames.push_back(source.nextFrame()); // header only, loaders do not reuse frame buffers
+            timestamps.push_back(source.getCurrentTimestamp());
+
+            const size_t frame_bytes = frames.back().total() * frames.back().elemSize();
+            held_bytes += frame_bytes;
+            if (memory_budget) {
+                memory_budget->add(MemoryComponent::FRAME_POOL, (long long)frame_bytes);
+                // Stop before the next frame of the same size would exceed the frame pool
+                if (!memory_budget->fits(MemoryComponent::FRAME_POOL, frame_bytes)) {
+                    break;
+                }
+            }
+        }
+
+        // Frames of a source are never tiled, so results do not depend on where a batch ends
+        std::vector<ClassificationResult> results;
+        if (frames.size() == 1) {
+            features.resize(1);
+            results.push_back(classifyFrame(frames.front(), features.front(), false));
+        } else {
+            results = processBatch(frames, &features);
+        }
+
+        for (size_t i = 0; i < results.size(); i++) {
+            stats.addFrameResult(timestamps[i], results[i]);
+            if (shotWriter) {
+                shotWriter->addFrame(timestamps[i], features[i], results[i]);
+            }
+        }
+
+        frames.clear();
+        if (memory_budget) {
+            memory_budget->add(MemoryComponent::FRAME_POOL, -(long long)held_bytes);
+        }
+    }
+}
+
+void ShotPipeline::processImages(InputSource& source, FilmStatistics& stats, ShotColumnWriter* shotWriter)
+{
+    ShotFeatures features;
+    while (source.hasNextFrame()) {
+        const cv::Mat frame = source.nextFrame();
+        const ClassificationResult result = processFrame(frame, features);
+        stats.addFrameResult(source.getCurrentTimestamp(), result);
+        if (shotWriter) {
+            shotWriter->addFrame(source.getCurrentTimestamp(), features, result);
+        }
+    }
+}
@@ -6,3 +6,831 @@
 //
 
 #include "TestDatasetEval.hpp"
+#include "ClassificationServer.hpp"
+#include "ShotColumnStore.hpp"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <sstream>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+    const char* const kModes[] = {"single", "threaded", "batched"};
+
+    ShotType labelFromDirectory(const std::string& name) {
+        std::string normalized;
+        for (char c : name) {
+            if (c != '_' && c != '-') {
+                normalized += (char)std::tolower((unsigned char)c);
+            }
+        }
+        for (ShotType type : {ShotType::CLOSE_UP, ShotType::MEDIUM, ShotType::WIDE}) {
+            std::string type_name = shotTypeToString(type);
+            type_name.erase(std::remove(type_name.begin(), type_name.end(), '_'), type_name.end());
+            std::transform(type_name.begin(), type_name.end(), type_name.begin(), ::tolower);
+            if (normalized == type_name) {
+                return type;
+            }
+        }
+        return ShotType::UNKNOWN;
+    }
+
+    // Bit-exact comparison, so that e.g. a different summation order is caught
+    bool sameBits(double a, double b) {
+        return std::memcmp(&a, &b, sizeof(double)) == 0;
+    }
+
+    bool sameResult(const ShotFeatures& fa, const ClassificationResult& ra,
+                    const ShotFeatures& fb, const ClassificationResult& rb) {
+        if (fa.object_count != fb.object_count || fa.content != fb.content ||
+            !sameBits(fa.largest_object_area, fb.largest_object_area) ||
+            !sameBits(fa.total_object_area, fb.total_object_area) ||
+            fa.object_centers.size() != fb.object_centers.size() ||
+            ra.predictedType != rb.predictedType || ra.probabilities.size() != rb.probabilities.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < fa.object_centers.size(); i++) {
+            if (fa.object_centers[i].x != fb.object_centers[i].x || fa.object_centers[i].y != fb.object_centers[i].y) {
+                return false;
+            }
+        }
+        for (const auto& [type, probability] : ra.probabilities) {
+            auto it = rb.probabilities.find(type);
+            if (it == rb.probabilities.end() || !sameBits(probability, it->second)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    double intersectionOverUnion(const cv::Rect& a, const cv::Rect& b) {
+        const double intersection = (a & b).area();
+        const double union_area = a.area() + b.area() - intersection;
+        return union_area > 0. ? intersection / union_area : 0.;
+    }
+
+    // Shot type of an "OK <type> ..." server response, empty for any other response
+    std::string responseType(const std::string& response) {
+        std::istringstream tokens(response);
+        std::string status, type;
+        tokens >> status >> type;
+        return status == "OK" ? type : "";
+    }
+
+    // Lines starting with '#' are comments
+    std::map<std::string, double> readBaseline(const std::string& path) {
+        std::map<std::string, double> baseline;
+        std::ifstream file(path);
+        std::string line, mode;
+        double fps = 0.;
+        while (std::getline(file, line)) {
+            std::istringstream fields(line);
+            if (line.rfind('#', 0) != 0 && fields >> mode >> fps) {
+                baseline[mode] = fps;
+            }
+        }
+        return baseline;
+    }
+
+    // Compares two shot column files column by column, floating point values bit for bit
+    bool sameShots(const std::string& pathA, const std::string& pathB) {
+        const ShotColumnReader a(pathA), b(pathB);
+        if (a.readShotTypes() != b.readShotTypes()) {
+            return false;
+        }
+        for (const char* name : {"face_count", "frame_count"}) {
+            if (a.readIntColumn(name) != b.readIntColumn(name)) {
+                return false;
+            }
+        }
+        for (const char* name : {"start_ms", "end_ms", "confidence", "largest_face_ratio"}) {
+            const std::vector<double> values_a = a.readDoubleColumn(name), values_b = b.readDoubleColumn(name);
+            if (values_a.size() != values_b.size() ||
+                !std::equal(values_a.begin(), values_a.end(), values_b.begin(), sameBits)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // InputSource over frames already in memory, so processSource() sees exactly the replayed images
+    class FrameListSource : public InputSource {
+        const std::vector<cv::Mat>& frames;
+        const std::vector<double>& timestamps;
+        size_t frame_count = 0;
+        size_t next = 0;
+        cv::Mat current;
+
+    public:
+        FrameListSource(const std::vector<cv::Mat>& frameList, const std::vector<double>& frameTimestamps, size_t count)
+            : InputSource("replay"), frames(frameList), timestamps(frameTimestamps), frame_count(count) {}
+
+        bool hasNextFrame() const override { return next < frame_count; }
+
+        cv::Mat& nextFrame() override {
+            current = frames[next++];
+            return current;
+        }
+
+        double getCurrentTimestamp() const override { return next > 0 ? timestamps[next - 1] : 0.; }
+    };
+}
+
+size_t PipelineReplay::loadImageCorpus(const std::string& testDir)
+{
+    namespace fs = std::filesystem;
+    if (!fs::is_directory(testDir)) {
+        throw std::runtime_error("Test corpus directory not found: " + testDir);
+    }
+
+    // Directory iteration order is unspecified, sort to keep the replay deterministic
+    std::vector<fs::path> paths;
+    for (const fs::directory_entry& entry : fs::recursive_directory_iterator(testDir)) {
+        std::string extension = entry.path().extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+        if (entry.is_regular_file() && (extension == ".jpg" || extension == ".jpeg" || extension == ".png")) {
+            paths.push_back(entry.path());
+        }
+    }
+    std::sort(paths.begin(), paths.end());
+
+    for (const fs::path& path : paths) {
+        ImageLoader loader(path.string());
+        frames.push_back(loader.nextFrame());
+        frame_names.push_back(path.string());
+        timestamps.push_back((double)timestamps.size());
+        labels.push_back(labelFromDirectory(path.parent_path().filename().string()));
+    }
+    image_count = frames.size();
+    return paths.size();
+}
+
+size_t PipelineReplay::addSynthesizedVideo(const std::string& videoPath, int framesPerImage)
+{
+    const cv::Size video_size(640, 360);
+    if (image_count == 0) {
+        return 0;
+    }
+
+    cv::VideoWriter writer(videoPath, cv::VideoWriter::fourcc('M', 'J', 'P', 'G'), 25., video_size);
+    if (!writer.isOpened()) {
+        std::cerr << "PipelineReplay: cannot write " << videoPath << ", skipping the video part" << std::endl;
+        return 0;
+    }
+    cv::Mat resized;
+    for (size_t i = 0; i < image_count; i++) {
+        cv::resize(frames[i], resized, video_size, 0., 0., cv::INTER_AREA);
+        for (int repeat = 0; repeat < framesPerImage; repeat++) {
+            writer.write(resized);
+        }
+    }
+    writer.release();
+
+    size_t added = 0;
+    VideoLoader video(videoPath);
+    while (video.hasNextFrame()) {
+        frames.push_back(video.nextFrame());
+        frame_names.push_back(videoPath + "@" + std::to_string(video.getCurrentTimestamp()) + "ms");
+        timestamps.push_back(video.getCurrentTimestamp());
+        labels.push_back(ShotType::UNKNOWN);
+        added++;
+    }
+    video_path = videoPath;
+    return added;
+}
+
+ReplayReport PipelineReplay::run(const std::string& baselinePath, double tolerance, bool record, int repetitions)
+{
+    namespace fs = std::filesystem;
+    ReplayReport report;
+    report.frame_count = frames.size();
+
+    const int thread_count = cv::getNumThreads();
+    const int previous_tiling = pipeline.getTiling();
+    pipeline.setTiling(0);
+
+    std::map<std::string, std::vector<ShotFeatures>> features;
+    std::map<std::string, std::vector<ClassificationResult>> results;
+    std::map<std::string, FilmStatistics> stats;
+    std::map<std::string, std::string> shot_paths;
+
+    // One pass of a mode; the batched mode goes through processSource() like a classified film
+    auto replayMode = [&](const std::string& name) {
+        std::vector<ShotFeatures>& mode_features = features[name];
+        std::vector<ClassificationResult>& mode_results = results[name];
+        stats.erase(name);
+        FilmStatistics& mode_stats = stats[name];
+        // Video timestamps start again at 0, so images and video go to separate shot files
+        ShotColumnWriter image_writer(shot_paths[name]);
+        ShotColumnWriter video_writer(shot_paths[name + "_video"]);
+
+        if (name == "batched") {
+            FrameListSource images(frames, timestamps, image_count);
+            pipeline.processSource(images, mode_stats, &image_writer);
+            if (!video_path.empty()) {
+                VideoLoader video(video_path);
+                pipeline.processSource(video, mode_stats, &video_writer);
+            }
+        } else {
+            mode_features.resize(frames.size());
+            mode_results.resize(frames.size());
+            for (size_t i = 0; i < frames.size(); i++) {
+                mode_results[i] = pipeline.processFrame(frames[i], mode_features[i]);
+                mode_stats.addFrameResult(timestamps[i], mode_results[i]);
+                ShotColumnWriter& writer = i < image_count ? image_writer : video_writer;
+                writer.addFrame(timestamps[i], mode_features[i], mode_results[i]);
+            }
+        }
+        image_writer.finish();
+        video_writer.finish();
+    };
+
+    for (const char* mode : kModes) {
+        const std::string name = mode;
+        shot_paths[name] = (fs::temp_directory_path() / ("film_shot_replay_" + name + ".shots")).string();
+        shot_paths[name + "_video"] = (fs::temp_directory_path() / ("film_shot_replay_" + name + "_video.shots")).string();
+        cv::setNumThreads(name == "single" ? 1 : thread_count);
+
+        // Warm-up pass (detector creation, caches), then the median of the timed passes
+        replayMode(name);
+        std::vector<double> seconds;
+        for (int repetition = 0; repetition < repetitions; repetition++) {
+            const double start = (double)cv::getTickCount();
+            replayMode(name);
+            seconds.push_back(((double)cv::getTickCount() - start) / cv::getTickFrequency());
+        }
+        if (!seconds.empty()) {
+            std::nth_element(seconds.begin(), seconds.begin() + seconds.size() / 2, seconds.end());
+            const double median = seconds[seconds.size() / 2];
+            report.frames_per_second[name] = median > 0. ? frames.size() / median : 0.;
+        }
+    }
+    cv::setNumThreads(thread_count);
+    pipeline.setTiling(previous_tiling);
+
+    // Every mode is compared against the single-threaded reference; processSource() does not
+    // hand out per-frame features, so the batched mode is compared through its statistics
+    // and the per-shot aggregates of its shot column file
+    const std::string reference = kModes[0];
+    for (const char* mode : kModes) {
+        const std::string name = mode;
+        for (size_t i = 0; i < results[name].size(); i++) {
+            if (!sameResult(features[reference][i], results[reference][i], features[name][i], results[name][i])) {
+                report.mismatches.push_back(name + ": " + frame_names[i] + " " +
+                                            shotTypeToString(results[reference][i].predictedType) + " vs " +
+                                            shotTypeToString(results[name][i].predictedType));
+            }
+        }
+        if (stats[name].getShotCounts() != stats[reference].getShotCounts() ||
+            stats[name].loadTimeline() != stats[reference].loadTimeline()) {
+            report.mismatches.push_back(name + ": FilmStatistics differ");
+        }
+        if (!sameShots(shot_paths[reference], shot_paths[name]) ||
+            !sameShots(shot_paths[reference + "_video"], shot_paths[name + "_video"])) {
+            report.mismatches.push_back(name + ": shot records differ");
+        }
+    }
+    for (const auto& [name, path] : shot_paths) {
+        fs::remove(path);
+    }
+    report.identical = report.mismatches.empty();
+
+    size_t labeled = 0, correct = 0;
+    for (size_t i = 0; i < frames.size(); i++) {
+        if (labels[i] != ShotType::UNKNOWN) {
+            labeled++;
+            correct += results[reference][i].predictedType == labels[i];
+        }
+    }
+    report.accuracy = labeled > 0 ? (double)correct / labeled : 0.;
+
+    if (record) {
+        std::ofstream file(baselinePath);
+        char host[256] = {};
+        gethostname(host, sizeof(host) - 1);
+        file << "# Replay throughput in frames per second, see README.md (Usage) for how to update it\n";
+        file << "# Recorded on host " << host << ", hardware threads " << std::thread::hardware_concurrency()
+             << ", OpenCV threads " << thread_count << ", OpenCV " << CV_VERSION << "\n";
+        for (const auto& [mode, fps] : report.frames_per_second) {
+            file << mode << ' ' << fps << '\n';
+        }
+        if (!file) {
+            report.failed_checks.push_back("throughput: cannot write baseline " + baselinePath);
+        }
+        return report;
+    }
+
+    report.baseline_fps = readBaseline(baselinePath);
+    for (const char* mode : kModes) {
+        auto baseline = report.baseline_fps.find(mode);
+        if (baseline == report.baseline_fps.end()) {
+            report.failed_checks.push_back(std::string("throughput: no baseline for ") + mode + " in " + baselinePath);
+        } else if (report.frames_per_second[mode] < baseline->second * (1. - tolerance)) {
+            report.throughput_ok = false;
+        }
+    }
+    return report;
+}
+
+void PipelineReplay::checkServer(const std::string& socketPath, ReplayReport& report)
+{
+    auto check = [&report](bool condition, const std::string& what) {
+        if (!condition) {
+            report.failed_checks.push_back("server: " + what);
+        }
+    };
+    if (image_count == 0) {
+        check(false, "no images loaded");
+        return;
+    }
+
+    try {
+        // Lone requests are classified with processFrame(), so the server must give the same type
+        ShotFeatures features;
+        const std::string image_type = shotTypeToString(pipeline.processFrame(frames[0], features).predictedType);
+        std::vector<uchar> encoded;
+        cv::imencode(".jpg", frames[0], encoded);
+        const cv::Mat decoded = cv::imdecode(encoded, cv::IMREAD_COLOR);
+        const std::string bytes_type = shotTypeToString(pipeline.processFrame(decoded, features).predictedType);
+
+        // The video worker uses processSource(), its answer must match the frames classified one by one
+        std::string video_response;
+        if (!video_path.empty()) {
+            FilmStatistics video_stats;
+            for (size_t i = image_count; i < frames.size(); i++) {
+                video_stats.addFrameResult(timestamps[i], pipeline.processFrame(frames[i], features));
+            }
+            const ShotType dominant = video_stats.getDominantShotType();
+            const int analyzed = video_stats.getAnalyzedFrames();
+            std::ostringstream expected;
+            expected << "OK " << shotTypeToString(dominant) << ' '
+                     << (analyzed > 0 ? (double)video_stats.getShotCounts().at(dominant) / analyzed : 0.)
+                     << " frames=" << analyzed;
+            for (ShotType counted : {ShotType::CLOSE_UP, ShotType::MEDIUM, ShotType::WIDE,
+                                     ShotType::BLACK, ShotType::CREDITS, ShotType::UNKNOWN}) {
+                auto it = video_stats.getShotCounts().find(counted);
+                expected << ' ' << shotTypeToString(counted) << '=' << (it != video_stats.getShotCounts().end() ? it->second : 0);
+            }
+            video_response = expected.str();
+        }
+
+        {
+            ClassificationServer server(pipeline);
+            server.start(socketPath);
+            std::future<void> running = std::async(std::launch::async, [&server]() { server.run(); });
+            {
+                ClassificationClient client(socketPath);
+                check(responseType(client.request("IMAGE " + frame_names[0])) == image_type,
+                      "IMAGE result differs from processFrame()");
+                check(responseType(client.request("BYTES " + std::to_string(encoded.size()), encoded)) == bytes_type,
+                      "BYTES result differs from processFrame()");
+                check(client.request("FROBNICATE").rfind("ERROR", 0) == 0, "unknown command not rejected");
+                check(client.request("IMAGE").rfind("ERROR", 0) == 0, "IMAGE without path not rejected");
+                check(client.request("STATS").rfind("OK served=2 ", 0) == 0, "STATS does not count 2 served requests");
+                if (!video_path.empty()) {
+                    check(client.request("VIDEO 0 -1 " + video_path) == video_response,
+                          "VIDEO result differs from processFrame()");
+                }
+            }
+            {
+                // The payload of an invalid BYTES request cannot be skipped, the connection is closed
+                ClassificationClient client(socketPath);
+                check(client.request("BYTES 0").rfind("ERROR", 0) == 0, "empty BYTES payload not rejected");
+            }
+            {
+                ClassificationClient client(socketPath);
+                check(client.request("SHUTDOWN") == "OK shutdown", "SHUTDOWN not acknowledged");
+            }
+            check(running.wait_for(std::chrono::seconds(10)) == std::future_status::ready,
+                  "run() did not return after SHUTDOWN");
+            server.stop(); // lets run() return if it missed the SHUTDOWN
+            check(!std::filesystem::exists(socketPath), "socket file left behind");
+        }
+
+        {
+            ServerOptions options;
+            options.queue_capacity = 0; // every request finds its queue full
+            options.video_queue_capacity = 0;
+            ClassificationServer server(pipeline, options);
+            server.start(socketPath);
+            std::future<void> running = std::async(std::launch::async, [&server]() { server.run(); });
+            {
+                ClassificationClient client(socketPath);
+                check(client.request("IMAGE " + frame_names[0]) == "BUSY", "full image queue does not answer BUSY");
+                check(client.request("VIDEO 0 -1 " + frame_names[0]) == "BUSY", "full video queue does not answer BUSY");
+                check(client.request("STATS").rfind("OK served=0 rejected=2 ", 0) == 0, "STATS does not count 2 rejections");
+            }
+            server.stop();
+            running.wait();
+        }
+
+        {
+            ServerOptions options;
+            options.max_connections = 1;
+            ClassificationServer server(pipeline, options);
+            server.start(socketPath);
+            std::future<void> running = std::async(std::launch::async, [&server]() { server.run(); });
+            {
+                ClassificationClient holder(socketPath);
+                check(holder.request("STATS").rfind("OK ", 0) == 0, "first connection not served");
+                ClassificationClient extra(socketPath);
+                check(extra.request("STATS") == "BUSY", "connection over max_connections does not get BUSY");
+            }
+            // The closed connection is reaped on the next accept once its thread has finished
+            bool served = false;
+            for (int attempt = 0; attempt < 100 && !served; attempt++) {
+                ClassificationClient client(socketPath);
+                served = client.request("STATS").rfind("OK ", 0) == 0;
+                if (!served) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                }
+            }
+            check(served, "connection slot not freed after a client disconnected");
+            server.stop();
+            running.wait();
+        }
+
+        {
+            // Payloads held by other connections are simulated by charging the loader queue share
+            MemoryBudget budget(encoded.size() * 8);
+            const long long held = (long long)budget.getLimit(MemoryComponent::LOADER_QUEUE);
+            ClassificationServer server(pipeline);
+            server.setMemoryBudget(&budget);
+            server.start(socketPath);
+            std::future<void> running = std::async(std::launch::async, [&server]() { server.run(); });
+            budget.add(MemoryComponent::LOADER_QUEUE, held);
+            try {
+                // The rejected payload spans several socket reads and must be skipped completely;
+                // a dropped connection throws here, before the server below is stopped
+                ClassificationClient client(socketPath);
+                const std::vector<uchar> rejected(200 * 1024 + 17, 0x7f);
+                check(client.request("BYTES " + std::to_string(rejected.size()), rejected) == "BUSY",
+                      "BYTES over the loader queue budget does not answer BUSY");
+                check(client.request("STATS").rfind("OK ", 0) == 0, "request after a rejected BYTES payload not served");
+                budget.add(MemoryComponent::LOADER_QUEUE, -held);
+                check(responseType(client.request("BYTES " + std::to_string(encoded.size()), encoded)) == bytes_type,
+                      "BYTES within the loader queue budget not classified");
+            } catch (const std::runtime_error& e) {
+                check(false, std::string("connection after a rejected BYTES payload: ") + e.what());
+            }
+            check(budget.getCurrent(MemoryComponent::LOADER_QUEUE) == 0, "loader queue budget not released");
+            server.stop();
+            running.wait();
+        }
+
+        {
+            std::ofstream(socketPath) << "not a socket";
+            ClassificationServer server(pipeline);
+            bool refused = false;
+            try {
+                server.start(socketPath);
+            } catch (const std::runtime_error&) {
+                refused = true;
+            }
+            check(refused && std::filesystem::is_regular_file(socketPath), "start() replaced a regular file");
+            std::filesystem::remove(socketPath);
+        }
+    } catch (const std::exception& e) {
+        check(false, e.what());
+    }
+}
+
+void PipelineReplay::checkTiling(ReplayReport& report, double upscale)
+{
+    constexpr double kMinOverlap = 0.5;
+    constexpr double kMinFoundShare = 0.9;
+    constexpr double kMinSpeedup = 1.5;
+    constexpr int kMinSpeedupThreads = 4;
+    constexpr int kRepetitions = 3;
+
+    const int previous_tiling = pipeline.getTiling();
+    size_t full_faces = 0, found_faces = 0;
+    std::vector<double> full_seconds(kRepetitions, 0.), tiled_seconds(kRepetitions, 0.);
+    try {
+        std::vector<cv::Mat> large(image_count);
+        for (size_t i = 0; i < image_count; i++) {
+            cv::resize(frames[i], large[i], cv::Size(), upscale, upscale, cv::INTER_LINEAR);
+        }
+
+        for (int run = 0; run < kRepetitions; run++) {
+            for (size_t i = 0; i < image_count; i++) {
+                pipeline.setTiling(0);
+                double start = (double)cv::getTickCount();
+                const std::vector<DetectedFeature> full = pipeline.detect(large[i]);
+                full_seconds[run] += ((double)cv::getTickCount() - start) / cv::getTickFrequency();
+
+                pipeline.setTiling(std::min(large[i].cols, large[i].rows) / 4);
+                start = (double)cv::getTickCount();
+                const std::vector<DetectedFeature> tiled = pipeline.detect(large[i]);
+                tiled_seconds[run] += ((double)cv::getTickCount() - start) / cv::getTickFrequency();
+                if (run > 0) {
+                    continue; // detections are compared once, later runs only time
+                }
+
+                // Detections are sorted by size, so the first one decides the shot type
+                for (size_t j = 0; j < full.size(); j++) {
+                    bool found = false;
+                    for (const DetectedFeature& candidate : tiled) {
+                        found = found || intersectionOverUnion(full[j].boundingBox, candidate.boundingBox) >= kMinOverlap;
+                    }
+                    found_faces += found;
+                    if (j == 0 && !found) {
+                        report.failed_checks.push_back("tiling: largest face of " + frame_names[i] + " not found");
+                    }
+                }
+                full_faces += full.size();
+            }
+        }
+    } catch (const std::exception& e) {
+        report.failed_checks.push_back(std::string("tiling: ") + e.what());
+    }
+    pipeline.setTiling(previous_tiling);
+
+    if (found_faces < kMinFoundShare * full_faces) {
+        report.failed_checks.push_back("tiling: found " + std::to_string(found_faces) + " of " +
+                                       std::to_string(full_faces) + " full-frame faces");
+    }
+
+    std::sort(full_seconds.begin(), full_seconds.end());
+    std::sort(tiled_seconds.begin(), tiled_seconds.end());
+    const double tiled_median = tiled_seconds[kRepetitions / 2];
+    report.tiling_speedup = tiled_median > 0. ? full_seconds[kRepetitions / 2] / tiled_median : 0.;
+    // Tiles only run side by side when there are cores for them
+    const int thread_count = std::min(cv::getNumThreads(), (int)std::thread::hardware_concurrency());
+    if (thread_count >= kMinSpeedupThreads && report.tiling_speedup < kMinSpeedup) {
+        std::ostringstream message;
+        message << "tiling: speed-up " << report.tiling_speedup << " on " << thread_count
+                << " threads, expected at least " << kMinSpeedup;
+        report.failed_checks.push_back(message.str());
+    }
+}
+
+void PipelineReplay::checkStartup(const std::string& modelPath, ReplayReport& report)
+{
+    constexpr double kMaxStartupRatio = 2.;
+    constexpr int kRepetitions = 3;
+    // Threads beyond the cores only queue up, so the comparison uses one detector per core
+    const int thread_count = std::min(cv::getNumThreads(), (int)std::thread::hardware_concurrency());
+    if (thread_count < 2) {
+        return; // a single core has no parallel startup to compare
+    }
+
+    // Cold start of a pool whose first `holders` checkouts overlap, like the tasks of a first batch
+    auto startupSeconds = [&modelPath](int holders) {
+        const double start = (double)cv::getTickCount();
+        DetectorPool pool(modelPath);
+        std::mutex mutex;
+        std::condition_variable all_held;
+        int held = 0;
+        std::vector<std::thread> threads;
+        for (int i = 0; i < holders; i++) {
+            threads.emplace_back([&]() {
+                DetectorPool::Lease lease = pool.checkout();
+                std::unique_lock<std::mutex> lock(mutex);
+                held++;
+                all_held.notify_all();
+                all_held.wait(lock, [&]() { return held == holders; });
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        return ((double)cv::getTickCount() - start) / cv::getTickFrequency();
+    };
+    auto medianSeconds = [&startupSeconds](int holders) {
+        std::vector<double> seconds;
+        for (int repetition = 0; repetition < kRepetitions; repetition++) {
+            seconds.push_back(startupSeconds(holders));
+        }
+        std::nth_element(seconds.begin(), seconds.begin() + seconds.size() / 2, seconds.end());
+        return seconds[seconds.size() / 2];
+    };
+
+    try {
+        const double single = medianSeconds(1);
+        const double parallel = medianSeconds(thread_count);
+        if (parallel > kMaxStartupRatio * single) {
+            report.failed_checks.push_back("startup: " + std::to_string(thread_count) + " threads took " +
+                                           std::to_string(parallel) + " s, one thread " + std::to_string(single) + " s");
+        }
+    } catch (const std::exception& e) {
+        report.failed_checks.push_back(std::string("startup: ") + e.what());
+    }
+}
+
+void PipelineReplay::checkPrefilter(ReplayReport& report)
+{
+    const bool previous_prefilter = pipeline.getPrefilter();
+    try {
+        for (size_t i = 0; i < image_count; i++) {
+            ShotFeatures features;
+            pipeline.setPrefilter(true);
+            const ShotType filtered = pipeline.processFrame(frames[i], features).predictedType;
+            pipeline.setPrefilter(false);
+            const ShotType unfiltered = pipeline.processFrame(frames[i], features).predictedType;
+            if (filtered != unfiltered) {
+                report.failed_checks.push_back("prefilter: " + frame_names[i] + " is " + shotTypeToString(filtered) +
+                                               ", without prefilter " + shotTypeToString(unfiltered));
+            }
+        }
+    } catch (const std::exception& e) {
+        report.failed_checks.push_back(std::string("prefilter: ") + e.what());
+    }
+    pipeline.setPrefilter(previous_prefilter);
+}
+
+void PipelineReplay::checkShotColumnStore(const std::string& path, ReplayReport& report)
+{
+    constexpr size_t kChunkRows = 16;
+    constexpr int kShotCount = 100;
+    constexpr double kFrameMs = 40.;
+    const ShotType types[] = {ShotType::WIDE, ShotType::UNKNOWN, ShotType::CREDITS,
+                              ShotType::BLACK, ShotType::MEDIUM, ShotType::CLOSE_UP};
+
+    // Consecutive shots differ in type, so the writer must close a shot exactly where expected
+    std::vector<ShotRecord> expected;
+    try {
+        ShotColumnWriter writer(path, kChunkRows);
+        double timestamp = 0.;
+        for (int shot = 0; shot < kShotCount; shot++) {
+            ShotRecord record;
+            record.type = types[shot % 6];
+            record.start_ms = timestamp;
+            double confidence_sum = 0.;
+            for (int frame = 0; frame <= shot % 5; frame++) {
+                ShotFeatures features;
+                features.object_count = (shot + frame) % 4;
+                features.largest_object_area = 100. * ((shot * 3 + frame) % 7);
+                features.total_area = 10000.;
+                ClassificationResult result;
+                result.predictedType = record.type;
+                result.probabilities[record.type] = 0.4 + 0.1 * ((shot + frame) % 6);
+                writer.addFrame(timestamp, features, result);
+
+                record.end_ms = timestamp;
+                record.face_count = std::max(record.face_count, features.object_count);
+                record.largest_face_ratio = std::max(record.largest_face_ratio,
+                                                     features.largest_object_area / features.total_area);
+                record.frame_count++;
+                confidence_sum += result.probabilities[record.type];
+                timestamp += kFrameMs;
+            }
+            record.confidence = confidence_sum / record.frame_count;
+            expected.push_back(record);
+        }
+        writer.finish();
+    } catch (const std::exception& e) {
+        report.failed_checks.push_back(std::string("column store: ") + e.what());
+        return;
+    }
+
+    const auto expect = [&report](bool ok, const std::string& what) {
+        if (!ok) {
+            report.failed_checks.push_back("column store: " + what);
+        }
+    };
+    try {
+        ShotColumnReader reader(path);
+        expect(reader.getRowCount() == expected.size(), "row count " + std::to_string(reader.getRowCount()));
+
+        // Ranges: everything, one chunk boundary, partly covered chunks, one shot, and empty ranges
+        const double boundary = expected[kChunkRows].start_ms;
+        const double ranges[][2] = {
+            {-std::numeric_limits<double>::infinity(), std::numeric_limits<double>::infinity()},
+            {boundary, boundary},
+            {boundary - 1., boundary + 1.},
+            {expected[5].start_ms + 1., expected[3 * kChunkRows + 2].start_ms},
+            {expected[40].start_ms, expected[40].end_ms},
+            {expected[7].start_ms + 1., expected[8].start_ms - 1.},
+            {5000., 4000.},
+            {expected.back().start_ms + 1., std::numeric_limits<double>::infinity()},
+        };
+        for (const auto& range : ranges) {
+            std::vector<double> start_ms, end_ms, confidence, ratio;
+            std::vector<int> face_count, frame_count;
+            std::vector<ShotType> type;
+            for (const ShotRecord& record : expected) {
+                if (record.start_ms >= range[0] && record.start_ms <= range[1]) {
+                    start_ms.push_back(record.start_ms);
+                    end_ms.push_back(record.end_ms);
+                    type.push_back(record.type);
+                    confidence.push_back(record.confidence);
+                    face_count.push_back(record.face_count);
+                    ratio.push_back(record.largest_face_ratio);
+                    frame_count.push_back(record.frame_count);
+                }
+            }
+
+            const std::string name = "[" + std::to_string(range[0]) + ", " + std::to_string(range[1]) + "] ";
+            expect(reader.readDoubleColumn("start_ms", range[0], range[1]) == start_ms, name + "start_ms");
+            expect(reader.readDoubleColumn("end_ms", range[0], range[1]) == end_ms, name + "end_ms");
+            expect(reader.readShotTypes(range[0], range[1]) == type, name + "type");
+            expect(reader.readDoubleColumn("confidence", range[0], range[1]) == confidence, name + "confidence");
+            expect(reader.readIntColumn("face_count", range[0], range[1]) == face_count, name + "face_count");
+            expect(reader.readDoubleColumn("largest_face_ratio", range[0], range[1]) == ratio, name + "largest_face_ratio");
+            expect(reader.readIntColumn("frame_count", range[0], range[1]) == frame_count, name + "frame_count");
+        }
+    } catch (const std::exception& e) {
+        report.failed_checks.push_back(std::string("column store: ") + e.what());
+    }
+
+    // A frame older than the previous one would break the shots and the chunk index
+    bool rejected = false;
+    try {
+        ShotColumnWriter writer(path, kChunkRows);
+        ClassificationResult result;
+        writer.addFrame(kFrameMs, ShotFeatures(), result);
+        writer.addFrame(0., ShotFeatures(), result);
+    } catch (const std::runtime_error&) {
+        rejected = true;
+    }
+    expect(rejected, "frame with a decreasing timestamp accepted");
+    std::filesystem::remove(path);
+}
+
+void PipelineReplay::checkMemoryBudget(const std::string& shotPath, ReplayReport& report)
+{
+    constexpr size_t kFramesInPool = 2;
+    constexpr size_t kTimelineEntries = 8;
+    constexpr size_t kTimelineEntryBytes = sizeof(std::pair<double, ShotType>);
+    constexpr size_t kWarmDetectors = 4;
+
+    const auto expect = [&report](bool ok, const std::string& what) {
+        if (!ok) {
+            report.failed_checks.push_back("memory budget: " + what);
+        }
+    };
+    size_t max_frame_bytes = 0;
+    for (const cv::Mat& frame : frames) {
+        max_frame_bytes = std::max(max_frame_bytes, frame.total() * frame.elemSize());
+    }
+    if (image_count == 0 || max_frame_bytes == 0) {
+        expect(false, "no corpus loaded");
+        return;
+    }
+
+    // The images and the video through processSource(), like a film; `snapshot` receives a copy
+    // of the statistics after the images, which shares the spill file with the original
+    auto classify = [this](FilmStatistics& stats, FilmStatistics& snapshot, const std::string& path) {
+        ShotColumnWriter writer(path);
+        FrameListSource images(frames, timestamps, image_count);
+        pipeline.processSource(images, stats, &writer);
+        writer.finish();
+        snapshot = stats;
+        if (!video_path.empty()) {
+            VideoLoader video(video_path);
+            pipeline.processSource(video, stats);
+        }
+    };
+
+    MemoryBudget* const previous_budget = pipeline.getMemoryBudget();
+    const std::string bounded_path = shotPath + ".bounded";
+    try {
+        pipeline.setMemoryBudget(nullptr);
+        FilmStatistics reference, reference_images;
+        classify(reference, reference_images, shotPath);
+
+        // Room for two frames, a few timeline entries and no idle detector at all; the pools
+        // start with several detectors each, which must be evicted down to one per pool
+        pipeline.warmUp(kWarmDetectors);
+        MemoryBudget budget(kFramesInPool * max_frame_bytes);
+        budget.setShare(MemoryComponent::LOADER_QUEUE, 0.);
+        budget.setShare(MemoryComponent::FRAME_POOL, 1.);
+        budget.setShare(MemoryComponent::DETECTION_CACHE, 0.);
+        budget.setShare(MemoryComponent::STATISTICS, (double)(kTimelineEntries * kTimelineEntryBytes) / budget.getTotal());
+        size_t cache_after = 0;
+        {
+            FilmStatistics bounded, bounded_images;
+            bounded.setMemoryBudget(&budget);
+            pipeline.setMemoryBudget(&budget);
+            classify(bounded, bounded_images, bounded_path);
+            cache_after = budget.getCurrent(MemoryComponent::DETECTION_CACHE);
+            pipeline.setMemoryBudget(previous_budget);
+
+            expect(bounded.getShotCounts() == reference.getShotCounts() &&
+                   bounded.loadTimeline() == reference.loadTimeline(), "statistics differ from the unbounded run");
+            expect(bounded_images.loadTimeline() == reference_images.loadTimeline(),
+                   "copy of spilled statistics changed when the original spilled again");
+            expect(bounded.getTimeline().size() < bounded.loadTimeline().size(), "timeline not spilled");
+            expect(sameShots(shotPath, bounded_path), "shot records differ from the unbounded run");
+        }
+
+        // The frame pool may overshoot by one frame whose size the previous frame did not predict
+        expect(budget.getPeak(MemoryComponent::FRAME_POOL) <= budget.getLimit(MemoryComponent::FRAME_POOL) + max_frame_bytes,
+               "frame pool peak " + std::to_string(budget.getPeak(MemoryComponent::FRAME_POOL)) + " bytes, limit " +
+               std::to_string(budget.getLimit(MemoryComponent::FRAME_POOL)));
+        expect(budget.getCurrent(MemoryComponent::FRAME_POOL) == 0, "frame pool not released");
+        expect(budget.getCurrent(MemoryComponent::STATISTICS) == 0, "statistics not released");
+        expect(cache_after < budget.getPeak(MemoryComponent::DETECTION_CACHE), "no detector evicted");
+    } catch (const std::exception& e) {
+        expect(false, e.what());
+    }
+    pipeline.setMemoryBudget(previous_budget);
+    std::filesystem::remove(shotPath);
+    std::filesystem::remove(bounded_path);
+}
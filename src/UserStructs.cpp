@@ -6,3 +6,26 @@
 //
 
 #include "UserStructs.hpp"
+
+std::string shotTypeToString(ShotType type)
+{
+    switch (type) {
+        case ShotType::CLOSE_UP: return "CLOSE_UP";
+        case ShotType::MEDIUM:   return "MEDIUM";
+        case ShotType::WIDE:     return "WIDE";
+        case ShotType::BLACK:    return "BLACK";
+        case ShotType::CREDITS:  return "CREDITS";
+        case ShotType::UNKNOWN:  return "UNKNOWN";
+    }
+    return "UNKNOWN";
+}
+
+ShotType shotTypeFromString(const std::string& name)
+{
+    for (ShotType type : {ShotType::CLOSE_UP, ShotType::MEDIUM, ShotType::WIDE, ShotType::BLACK, ShotType::CREDITS}) {
+        if (name == shotTypeToString(type)) {
+            return type;
+        }
+    }
+    return ShotType::UNKNOWN;
+}
@@ -5,42 +5,169 @@
 #include <filesystem>
 #include "FilmShotClassifier.hpp"
 
-int main()
+namespace {
+    void printUsage(const char* program)
+    {
+        std::cerr << "Usage:\n"
+                  << "  " << program << " [--memory <MB>] [--tile <max_face_px>] [--shots <file>] <image_or_video>\n"
+                  << "  " << program << " [--memory <MB>] --serve <socket>\n"
+                  << "  " << program << " --replay <test_dir> <baseline_file> [tolerance] [--record]\n"
+                  << "  " << program << " --client <socket> <request...>\n";
+    }
+
+    bool isImagePath(const std::string& path)
+    {
+        std::string extension = std::filesystem::path(path).extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+        return extension == ".jpg" || extension == ".jpeg" || extension == ".png" || extension == ".bmp";
+    }
+}
+
+int main(int argc, char** argv)
 {
-// just a code prototype, comment out to build
     std::string data_path = "path";
-    std::string haar_filter_path1 = "path";
-    std::string haar_filter_path2 = "path";
-    
-    
-    ImageLoader image_loader(data_path);
-    Preprocessing preprocess;
-    FeatureDetector frontal_face_detector(haar_filter_path1);
-    FeatureDetector side_face_detector(haar_filter_path2);
-    ShotFeatureExtractor shot_feature_extractor;
-    ShotClassifier shot_classifier;
-    FilmStatistics film_stats;
-    
-    std::vector<DetectedFeature> detected_frontal_face_vect;
-    std::vector<DetectedFeature> detected_left_face_vect;
-    std::vector<DetectedFeature> features_vect;
-    
-    ShotFeatures shot_features;
-    ClassificationResult classification_result;
-    
-    while(image_loader.hasNextFrame())
-    {
-        preprocess.LoadFrame(image_loader.nextFrame());
-        //preprocessing methods calling...
-        
-        detected_frontal_face_vect = frontal_face_detector.detect(preprocess.GetProcessedImage());
-        detected_left_face_vect = side_face_detector.detect(preprocess.GetProcessedImage());
-        // concatenate vectors... -> features_vect
-        
-        shot_features = shot_feature_extractor.extract(preprocess.GetProcessedImage(), features_vect);
-        classification_result = shot_classifier.classify(shot_features);
-        film_stats.addFrameResult(image_loader.getCurrentTimestamp(), classification_result);
+    std::string haar_filter_path1 = "src/haarcascade_frontalface_default.xml";
+    std::string haar_filter_path2 = "src/haarcascade_profileface.xml";
+
+    if (argc < 2) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    std::string mode = argv[1];
+
+    // Tiled detection spreads one large still over all cores
+    int tile_max_face_size = 0;
+    // Per-shot records in the columnar format of ShotColumnWriter
+    std::string shots_path;
+    // Memory budget in megabytes shared by the loader, frame pool, detectors and statistics (0 = unbounded)
+    size_t memory_megabytes = 0;
+    int arg = 1;
+    while ((mode == "--tile" || mode == "--shots" || mode == "--memory") && arg + 2 < argc) {
+        if (mode == "--tile") {
+            tile_max_face_size = std::atoi(argv[arg + 1]);
+        } else if (mode == "--memory") {
+            memory_megabytes = std::strtoull(argv[arg + 1], nullptr, 10);
+        } else {
+            shots_path = argv[arg + 1];
+        }
+        arg += 2;
+        mode = argv[arg];
     }
-        
+
+    // Declared before the pools, which give their detectors back to it on destruction
+    std::unique_ptr<MemoryBudget> memory_budget;
+    if (memory_megabytes > 0) {
+        memory_budget = std::make_unique<MemoryBudget>(memory_megabytes * 1024 * 1024);
+    }
+
+    try {
+        if (mode == "--client") {
+            if (argc < arg + 3) {
+                printUsage(argv[0]);
+                return 1;
+            }
+            std::string request = argv[arg + 2];
+            for (int i = arg + 3; i < argc; i++) {
+                request += std::string(" ") + argv[i];
+            }
+            ClassificationClient client(argv[arg + 1]);
+            std::string response = client.request(request);
+            std::cout << response << std::endl;
+            return response.rfind("OK", 0) == 0 ? 0 : 2;
+        }
+
+        // Models are parsed once; worker threads get their own detectors from the pools on first use
+        DetectorPool frontal_face_pool(haar_filter_path1);
+        DetectorPool side_face_pool(haar_filter_path2);
+
+        ShotPipeline pipeline(frontal_face_pool, side_face_pool);
+        pipeline.setTiling(tile_max_face_size);
+        pipeline.setMemoryBudget(memory_budget.get());
+
+        if (mode == "--serve") {
+            if (argc < arg + 2) {
+                printUsage(argv[0]);
+                return 1;
+            }
+            // A server lives long enough to build every worker's detectors up front
+            pipeline.warmUp(cv::getNumThreads());
+            ClassificationServer server(pipeline);
+            server.setMemoryBudget(memory_budget.get());
+            server.start(argv[arg + 1]);
+            std::cout << "Listening on " << argv[arg + 1] << std::endl;
+            server.run();
+            return 0;
+        }
+
+        if (mode == "--replay") {
+            if (argc < arg + 3) {
+                printUsage(argv[0]);
+                return 1;
+            }
+            PipelineReplay replay(pipeline);
+            replay.loadImageCorpus(argv[arg + 1]);
+            replay.addSynthesizedVideo((std::filesystem::temp_directory_path() / "film_shot_replay.avi").string());
+            const bool record = std::string(argv[argc - 1]) == "--record";
+            const bool has_tolerance = argc > arg + 3 && std::string(argv[arg + 3]) != "--record";
+            ReplayReport report = replay.run(argv[arg + 2], has_tolerance ? std::atof(argv[arg + 3]) : 0.2, record);
+            replay.checkStartup(haar_filter_path1, report);
+            replay.checkTiling(report);
+            replay.checkPrefilter(report);
+            replay.checkServer((std::filesystem::temp_directory_path() / "film_shot_replay.sock").string(), report);
+            replay.checkShotColumnStore((std::filesystem::temp_directory_path() / "film_shot_replay.shots").string(), report);
+            replay.checkMemoryBudget((std::filesystem::temp_directory_path() / "film_shot_replay_budget.shots").string(), report);
+
+            std::cout << "Replayed " << report.frame_count << " frames, accuracy on labeled images: "
+                      << report.accuracy * 100. << " %\n";
+            for (const auto& [replay_mode, fps] : report.frames_per_second) {
+                auto baseline = report.baseline_fps.find(replay_mode);
+                std::cout << "  " << replay_mode << ": " << fps << " fps";
+                if (baseline != report.baseline_fps.end()) {
+                    std::cout << " (baseline " << baseline->second << ")";
+                }
+                std::cout << "\n";
+            }
+            std::cout << "  tiling speed-up on large stills: " << report.tiling_speedup << "x\n";
+            for (const std::string& mismatch : report.mismatches) {
+                std::cout << "  MISMATCH " << mismatch << "\n";
+            }
+            for (const std::string& failed : report.failed_checks) {
+                std::cout << "  FAILED " << failed << "\n";
+            }
+            std::cout << (report.passed() ? "PASSED" : "FAILED") << std::endl;
+            return report.passed() ? 0 : 1;
+        }
+
+        data_path = mode;
+        FilmStatistics film_stats;
+        film_stats.setMemoryBudget(memory_budget.get());
+        std::unique_ptr<ShotColumnWriter> shot_writer;
+        if (!shots_path.empty()) {
+            shot_writer = std::make_unique<ShotColumnWriter>(shots_path);
+        }
+        if (isImagePath(data_path)) {
+            ImageLoader image_loader(data_path);
+            if (tile_max_face_size > 0) {
+                // Stills are independent, each one is detected in parallel tiles
+                pipeline.processImages(image_loader, film_stats, shot_writer.get());
+            } else {
+                pipeline.processSource(image_loader, film_stats, shot_writer.get());
+            }
+        } else {
+            VideoLoader video_loader(data_path);
+            pipeline.processSource(video_loader, film_stats, shot_writer.get());
+        }
+        if (shot_writer) {
+            shot_writer->finish();
+        }
+        film_stats.printSummary();
+        if (memory_budget) {
+            memory_budget->printReport();
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
     return 0;
 }